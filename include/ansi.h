@@ -346,3 +346,353 @@
 #pragma endregion
 
 #endif
+
+
+#ifdef _ANSI_EMIT
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/// @brief Upper bound of bytes written by a single emitter.
+/// @details Two 10-digit parameters of @c ansi_cup() plus introducer, separator and final byte.
+#define ANSI_SEQ_MAX 24
+
+#ifndef ANSI_BUF_SIZE
+/// @brief Capacity of the @c ansi_buf accumulator in bytes.
+#define ANSI_BUF_SIZE 4096
+#endif
+
+
+/// @brief Two-digit lookup table for decimal formatting.
+static const char ansi_digits_[201] =
+    "00010203040506070809101112131415161718192021222324"
+    "25262728293031323334353637383940414243444546474849"
+    "50515253545556575859606162636465666768697071727374"
+    "75767778798081828384858687888990919293949596979899";
+
+/// @brief Writes decimal representation of a number.
+/// @param[out] buf Destination, at least 10 bytes.
+/// @param[in]  n   Number.
+/// @return Number of bytes written.
+static inline size_t ansi_utoa_(char *buf, unsigned n)
+{
+    char tmp[10];
+    char *p = tmp + sizeof tmp;
+    size_t len;
+
+    while (n >= 100)
+    {
+        const unsigned i = (n % 100) * 2;
+        n /= 100;
+        *--p = ansi_digits_[i + 1];
+        *--p = ansi_digits_[i];
+    }
+
+    if (n >= 10)
+    {
+        *--p = ansi_digits_[n * 2 + 1];
+        *--p = ansi_digits_[n * 2];
+    }
+    else *--p = (char)('0' + n);
+
+    len = (size_t)(tmp + sizeof tmp - p);
+    memcpy(buf, p, len);
+    return len;
+}
+
+/// @brief Writes a single-valued sequence.
+/// @param[out] buf   Destination.
+/// @param[in]  n     Value.
+/// @param[in]  delim Final byte.
+/// @return Number of bytes written.
+static inline size_t ansi_csi1_(char *buf, unsigned n, char delim)
+{
+    size_t len = 2;
+
+    buf[0] = '\x1b';
+    buf[1] = '[';
+    len += ansi_utoa_(buf + len, n);
+    buf[len++] = delim;
+    return len;
+}
+
+/// @brief Writes a two-valued sequence.
+/// @param[out] buf   Destination.
+/// @param[in]  n     First value.
+/// @param[in]  m     Second value.
+/// @param[in]  delim Final byte.
+/// @return Number of bytes written.
+static inline size_t ansi_csi2_(char *buf, unsigned n, unsigned m, char delim)
+{
+    size_t len = 2;
+
+    buf[0] = '\x1b';
+    buf[1] = '[';
+    len += ansi_utoa_(buf + len, n);
+    buf[len++] = ';';
+    len += ansi_utoa_(buf + len, m);
+    buf[len++] = delim;
+    return len;
+}
+
+/// @brief Writes an 8-bit color sequence.
+/// @param[out] buf   Destination.
+/// @param[in]  layer 38 for foreground, 48 for background, 58 for underline.
+/// @param[in]  n     8-bit color.
+/// @return Number of bytes written.
+static inline size_t ansi_col_(char *buf, unsigned layer, unsigned char n)
+{
+    size_t len = 2;
+
+    buf[0] = '\x1b';
+    buf[1] = '[';
+    len += ansi_utoa_(buf + len, layer);
+    memcpy(buf + len, ";5;", 3);
+    len += 3;
+    len += ansi_utoa_(buf + len, n);
+    buf[len++] = 'm';
+    return len;
+}
+
+/// @brief Writes an RGB color sequence.
+/// @param[out] buf   Destination.
+/// @param[in]  layer 38 for foreground, 48 for background, 58 for underline.
+/// @param[in]  r     Red channel.
+/// @param[in]  g     Green channel.
+/// @param[in]  b     Blue channel.
+/// @return Number of bytes written.
+static inline size_t ansi_rgb_(char *buf, unsigned layer, unsigned char r, unsigned char g, unsigned char b)
+{
+    size_t len = 2;
+
+    buf[0] = '\x1b';
+    buf[1] = '[';
+    len += ansi_utoa_(buf + len, layer);
+    memcpy(buf + len, ";2;", 3);
+    len += 3;
+    len += ansi_utoa_(buf + len, r);
+    buf[len++] = ';';
+    len += ansi_utoa_(buf + len, g);
+    buf[len++] = ';';
+    len += ansi_utoa_(buf + len, b);
+    buf[len++] = 'm';
+    return len;
+}
+
+
+/// @brief Runtime @c CUU.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   Number of lines to go up.
+/// @return Number of bytes written.
+static inline size_t ansi_cuu(char *buf, unsigned n) { return ansi_csi1_(buf, n, 'A'); }
+
+/// @brief Runtime @c CUD.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   Number of lines to go down.
+/// @return Number of bytes written.
+static inline size_t ansi_cud(char *buf, unsigned n) { return ansi_csi1_(buf, n, 'B'); }
+
+/// @brief Runtime @c CUF.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   Number of cells to go forward.
+/// @return Number of bytes written.
+static inline size_t ansi_cuf(char *buf, unsigned n) { return ansi_csi1_(buf, n, 'C'); }
+
+/// @brief Runtime @c CUB.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   Number of cells to go back.
+/// @return Number of bytes written.
+static inline size_t ansi_cub(char *buf, unsigned n) { return ansi_csi1_(buf, n, 'D'); }
+
+/// @brief Runtime @c CNL.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   Number of lines to go down.
+/// @return Number of bytes written.
+static inline size_t ansi_cnl(char *buf, unsigned n) { return ansi_csi1_(buf, n, 'E'); }
+
+/// @brief Runtime @c CPL.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   Number of lines to go up.
+/// @return Number of bytes written.
+static inline size_t ansi_cpl(char *buf, unsigned n) { return ansi_csi1_(buf, n, 'F'); }
+
+/// @brief Runtime @c CHA.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   Column number.
+/// @return Number of bytes written.
+static inline size_t ansi_cha(char *buf, unsigned n) { return ansi_csi1_(buf, n, 'G'); }
+
+/// @brief Runtime @c CUP.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   Row number.
+/// @param[in]  m   Column number.
+/// @return Number of bytes written.
+static inline size_t ansi_cup(char *buf, unsigned n, unsigned m) { return ansi_csi2_(buf, n, m, 'H'); }
+
+/// @brief Runtime @c HVP.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   Row number.
+/// @param[in]  m   Column number.
+/// @return Number of bytes written.
+static inline size_t ansi_hvp(char *buf, unsigned n, unsigned m) { return ansi_csi2_(buf, n, m, 'f'); }
+
+/// @brief Runtime @c ED.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   Erase mode.
+/// @return Number of bytes written.
+static inline size_t ansi_ed(char *buf, unsigned n) { return ansi_csi1_(buf, n, 'J'); }
+
+/// @brief Runtime @c EL.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   Erase mode.
+/// @return Number of bytes written.
+static inline size_t ansi_el(char *buf, unsigned n) { return ansi_csi1_(buf, n, 'K'); }
+
+/// @brief Runtime @c SU.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   Number of lines.
+/// @return Number of bytes written.
+static inline size_t ansi_su(char *buf, unsigned n) { return ansi_csi1_(buf, n, 'S'); }
+
+/// @brief Runtime @c SD.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   Number of lines.
+/// @return Number of bytes written.
+static inline size_t ansi_sd(char *buf, unsigned n) { return ansi_csi1_(buf, n, 'T'); }
+
+/// @brief Runtime @c SGR.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   Code.
+/// @return Number of bytes written.
+static inline size_t ansi_sgr(char *buf, unsigned n) { return ansi_csi1_(buf, n, 'm'); }
+
+
+/// @brief Runtime @c FG_SET.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   8-bit color.
+/// @return Number of bytes written.
+static inline size_t ansi_fg_set(char *buf, unsigned char n) { return ansi_col_(buf, 38, n); }
+
+/// @brief Runtime @c FG_RGB.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  r   Red channel.
+/// @param[in]  g   Green channel.
+/// @param[in]  b   Blue channel.
+/// @return Number of bytes written.
+static inline size_t ansi_fg_rgb(char *buf, unsigned char r, unsigned char g, unsigned char b) { return ansi_rgb_(buf, 38, r, g, b); }
+
+/// @brief Runtime @c BG_SET.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   8-bit color.
+/// @return Number of bytes written.
+static inline size_t ansi_bg_set(char *buf, unsigned char n) { return ansi_col_(buf, 48, n); }
+
+/// @brief Runtime @c BG_RGB.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  r   Red channel.
+/// @param[in]  g   Green channel.
+/// @param[in]  b   Blue channel.
+/// @return Number of bytes written.
+static inline size_t ansi_bg_rgb(char *buf, unsigned char r, unsigned char g, unsigned char b) { return ansi_rgb_(buf, 48, r, g, b); }
+
+/// @brief Runtime @c UNDERLINE_SET.
+/// @warning Not widely supported.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  n   8-bit color.
+/// @return Number of bytes written.
+static inline size_t ansi_underline_set(char *buf, unsigned char n) { return ansi_col_(buf, 58, n); }
+
+/// @brief Runtime @c UNDERLINE_RGB.
+/// @warning Not widely supported.
+/// @param[out] buf Destination, at least @c ANSI_SEQ_MAX bytes.
+/// @param[in]  r   Red channel.
+/// @param[in]  g   Green channel.
+/// @param[in]  b   Blue channel.
+/// @return Number of bytes written.
+static inline size_t ansi_underline_rgb(char *buf, unsigned char r, unsigned char g, unsigned char b) { return ansi_rgb_(buf, 58, r, g, b); }
+
+
+/// @brief Output accumulator.
+/// @details Collects text and sequences and hands them to the file in a single @c fwrite on flush.
+typedef struct ansi_buf
+{
+    /// @brief Destination file.
+    FILE *file;
+
+    /// @brief Number of pending bytes.
+    size_t len;
+
+    /// @brief Pending bytes.
+    char data[ANSI_BUF_SIZE];
+} ansi_buf;
+
+/// @brief Initializes an accumulator.
+/// @param[out] b    Accumulator.
+/// @param[in]  file Destination file.
+static inline void ansi_buf_init(ansi_buf *b, FILE *file)
+{
+    b->file = file;
+    b->len = 0;
+}
+
+/// @brief Writes pending bytes to the file.
+/// @param[in,out] b Accumulator.
+/// @return Zero on success, @c EOF if the file reported a short write.
+static inline int ansi_buf_flush(ansi_buf *b)
+{
+    const size_t len = b->len;
+
+    b->len = 0;
+    return len == 0 || fwrite(b->data, 1, len, b->file) == len ? 0 : EOF;
+}
+
+/// @brief Makes room for @c n more bytes, flushing if needed.
+/// @param[in,out] b Accumulator.
+/// @param[in]     n Number of bytes, at most @c ANSI_BUF_SIZE.
+/// @return Pointer to the free space.
+static inline char *ansi_buf_reserve(ansi_buf *b, size_t n)
+{
+    if (ANSI_BUF_SIZE - b->len < n)
+        ansi_buf_flush(b);
+
+    return b->data + b->len;
+}
+
+/// @brief Appends bytes to the accumulator.
+/// @details Blocks larger than the accumulator are written through directly.
+/// @param[in,out] b   Accumulator.
+/// @param[in]     s   Bytes.
+/// @param[in]     len Number of bytes.
+static inline void ansi_buf_write(ansi_buf *b, const char *s, size_t len)
+{
+    if (len > ANSI_BUF_SIZE)
+    {
+        ansi_buf_flush(b);
+        fwrite(s, 1, len, b->file);
+        return;
+    }
+
+    memcpy(ansi_buf_reserve(b, len), s, len);
+    b->len += len;
+}
+
+/// @brief Appends a null-terminated string to the accumulator.
+/// @param[in,out] b Accumulator.
+/// @param[in]     s String, may be any of the macros above.
+static inline void ansi_buf_puts(ansi_buf *b, const char *s) { ansi_buf_write(b, s, strlen(s)); }
+
+/// @brief Appends the output of a runtime emitter to the accumulator.
+/// @details Reserves before reading the length, which the reservation may reset by flushing; evaluates @p b once.
+/// @param b       Accumulator.
+/// @param emitter Emitter such as @c ansi_cup or @c ansi_fg_rgb.
+/// @param ...     Emitter arguments following the destination.
+#define ANSI_BUF_PUT(b, emitter, ...)                                   \
+    do                                                                  \
+    {                                                                   \
+        ansi_buf *ansi_b_ = (b);                                        \
+        char *ansi_p_ = ansi_buf_reserve(ansi_b_, ANSI_SEQ_MAX);        \
+        ansi_b_->len += emitter(ansi_p_, __VA_ARGS__);                  \
+    } while (0)
+
+#endif
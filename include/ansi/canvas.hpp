@@ -0,0 +1,338 @@
+/// @file canvas.hpp
+/// @author Danylo Marchenko (cdanymar)
+/// @brief Defines a drawing surface rendered with Unicode braille characters, eight pixels per cell.
+/// @version 1.0
+/// @date 2024-08-11
+/// @copyright Copyright (c) 2024
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "csi.hpp"
+#include "iomanip.hpp"
+#include "style.hpp"
+
+/// @brief ANSI Escape Codes.
+namespace ansi
+{
+    /// @brief Braille canvas.
+    /// @details Every cell holds a 2x4 block of pixels as the eight dots of a braille character, stored as one byte, and
+    /// the foreground color of the last drawing into it. Rendering emits one SGR per run of cells of the same color.
+    class canvas
+    {
+    public:
+        /// @brief Creates a blank canvas.
+        /// @param[in] columns Width in cells, twice as many pixels.
+        /// @param[in] rows    Height in cells, four times as many pixels.
+        canvas(const std::size_t columns, const std::size_t rows)
+            : columns_(columns), rows_(rows), dots_(columns * rows), colors_(columns * rows)
+        {
+        }
+
+        /// @brief Width in pixels.
+        auto width() const -> std::size_t { return columns_ * 2; }
+
+        /// @brief Height in pixels.
+        auto height() const -> std::size_t { return rows_ * 4; }
+
+        /// @brief Clears all pixels and colors.
+        auto clear() -> void
+        {
+            std::fill(dots_.begin(), dots_.end(), std::uint8_t{0});
+            std::fill(colors_.begin(), colors_.end(), color{});
+        }
+
+        /// @brief Selects the color of the following drawings.
+        /// @tparam N Number of values.
+        /// @param[in] obj Foreground SGR, e.g. @c fg::red, @c fg::set() or @c fg::rgb() .
+        template <std::size_t N>
+        auto pen(const csi<N>& obj) -> void
+        {
+            style s;
+            s.apply(obj);
+            pen_ = s.fg;
+        }
+
+        /// @brief Sets a pixel, ignoring pixels outside the canvas.
+        /// @param[in] x Column, 0-based from the left.
+        /// @param[in] y Row, 0-based from the top.
+        auto point(const long x, const long y) -> void
+        {
+            if (!inside(x, y))
+                return;
+
+            const std::size_t i = static_cast<std::size_t>(y / 4) * columns_ + static_cast<std::size_t>(x / 2);
+            dots_[i] |= bit[y % 4][x % 2];
+            colors_[i] = pen_;
+        }
+
+        /// @brief Draws a line, clipped to the canvas.
+        /// @details A line with an end outside the canvas only takes the steps near it: the state of the first one is
+        /// computed directly, so the pixels drawn are the same as when stepping from the start.
+        /// @param[in] x0 Start column.
+        /// @param[in] y0 Start row.
+        /// @param[in] x1 End column.
+        /// @param[in] y1 End row.
+        auto line(long x0, long y0, const long x1, const long y1) -> void
+        {
+            const long dx = std::labs(x1 - x0);
+            const long dy = -std::labs(y1 - y0);
+            const long sx = x0 < x1 ? 1 : -1;
+            const long sy = y0 < y1 ? 1 : -1;
+            long err = dx + dy;
+
+            // The major axis moves on every step, so the line takes as many steps as it is long along it.
+            long first = 0;
+            long last = std::max(dx, -dy);
+
+            if ((!inside(x0, y0) || !inside(x1, y1)) && !steps_inside(x0, y0, x1, y1, first, last))
+                return;
+
+            // The minor axis has moved by the rounded share of the first steps.
+            if (first > 0)
+            {
+                const long long major = std::max(dx, -dy);
+                const long long minor = std::min(dx, -dy);
+                const auto moved = static_cast<long>((2 * first * minor + major) / (2 * major));
+
+                if (dx >= -dy)
+                {
+                    x0 += first * sx;
+                    y0 += moved * sy;
+                    err += moved * dx + first * dy;
+                }
+                else
+                {
+                    y0 += first * sy;
+                    x0 += moved * sx;
+                    err += first * dx + moved * dy;
+                }
+            }
+
+            for (long step = first;; step++)
+            {
+                point(x0, y0);
+
+                if (step == last)
+                    break;
+
+                const long e2 = 2 * err;
+                if (e2 >= dy)
+                {
+                    err += dy;
+                    x0 += sx;
+                }
+                if (e2 <= dx)
+                {
+                    err += dx;
+                    y0 += sy;
+                }
+            }
+        }
+
+        /// @brief Fills a rectangle, clipped to the canvas.
+        /// @details Works a cell at a time, combining the dots of the covered columns and rows into one mask.
+        /// @param[in] x0 First column.
+        /// @param[in] y0 First row.
+        /// @param[in] x1 Last column, inclusive.
+        /// @param[in] y1 Last row, inclusive.
+        auto fill(long x0, long y0, long x1, long y1) -> void
+        {
+            if (x0 > x1)
+                std::swap(x0, x1);
+            if (y0 > y1)
+                std::swap(y0, y1);
+
+            x0 = std::max(x0, 0L);
+            y0 = std::max(y0, 0L);
+            x1 = std::min(x1, static_cast<long>(width()) - 1);
+            y1 = std::min(y1, static_cast<long>(height()) - 1);
+
+            if (x0 > x1 || y0 > y1)
+                return;
+
+            for (long cy = y0 / 4; cy <= y1 / 4; cy++)
+            {
+                std::uint8_t rows = 0;
+                for (long y = std::max(y0, cy * 4); y <= std::min(y1, cy * 4 + 3); y++)
+                    rows |= bit[y % 4][0] | bit[y % 4][1];
+
+                for (long cx = x0 / 2; cx <= x1 / 2; cx++)
+                {
+                    std::uint8_t columns = 0;
+                    if (x0 <= cx * 2)
+                        columns |= left;
+                    if (x1 >= cx * 2 + 1)
+                        columns |= right;
+
+                    const std::size_t i = static_cast<std::size_t>(cy) * columns_ + static_cast<std::size_t>(cx);
+                    dots_[i] |= rows & columns;
+                    colors_[i] = pen_;
+                }
+            }
+        }
+
+        /// @brief Renders the canvas.
+        /// @details Rows are separated by line feeds; empty cells are spaces. A reset follows if any color was set.
+        /// @param[out] out String to append to, reused between frames to avoid allocations.
+        auto render(std::string& out) const -> void
+        {
+            color current;
+
+            for (std::size_t r = 0; r < rows_; r++)
+            {
+                if (r > 0)
+                    out += '\n';
+
+                for (std::size_t c = 0; c < columns_; c++)
+                {
+                    const std::size_t i = r * columns_ + c;
+                    const std::uint8_t d = dots_[i];
+
+                    if (d == 0)
+                    {
+                        out += ' ';
+                        continue;
+                    }
+
+                    if (colors_[i] != current)
+                    {
+                        current = colors_[i];
+                        select(out, current);
+                    }
+
+                    // U+2800 + d as UTF-8.
+                    const char utf8[3] = {'\xE2', static_cast<char>(0xA0 | d >> 6), static_cast<char>(0x80 | (d & 0x3F))};
+                    out.append(utf8, sizeof utf8);
+                }
+            }
+
+            if (current != color{})
+                out.append(table::sgr[0].view());
+        }
+
+    private:
+        /// @brief Dot of each pixel within a cell, by row and column.
+        static constexpr std::uint8_t bit[4][2] = {{0x01, 0x08}, {0x02, 0x10}, {0x04, 0x20}, {0x40, 0x80}};
+
+        /// @brief Dots of the left pixel column.
+        static constexpr std::uint8_t left = 0x01 | 0x02 | 0x04 | 0x40;
+
+        /// @brief Dots of the right pixel column.
+        static constexpr std::uint8_t right = 0x08 | 0x10 | 0x20 | 0x80;
+
+        /// @brief Tests whether a pixel is on the canvas.
+        auto inside(const long x, const long y) const -> bool
+        {
+            return x >= 0 && y >= 0 && static_cast<std::size_t>(x) < width() && static_cast<std::size_t>(y) < height();
+        }
+
+        /// @brief Narrows the steps of a line to those that may draw on the canvas.
+        /// @details Cuts the ideal segment to the canvas grown by half a pixel with the Liang-Barsky algorithm, which holds
+        /// every pixel of a step landing on the canvas, and keeps a step of margin on each side for rounding.
+        /// @param[in]     x0    Start column.
+        /// @param[in]     y0    Start row.
+        /// @param[in]     x1    End column.
+        /// @param[in]     y1    End row.
+        /// @param[out]    first First step.
+        /// @param[in,out] last  Last step, the number of steps of the whole line on input.
+        /// @return Whether any step may draw on the canvas.
+        auto steps_inside(const long x0, const long y0, const long x1, const long y1, long& first, long& last) const -> bool
+        {
+            const double dx = static_cast<double>(x1) - static_cast<double>(x0);
+            const double dy = static_cast<double>(y1) - static_cast<double>(y0);
+            const double p[4] = {-dx, dx, -dy, dy};
+            const double q[4] = {
+                static_cast<double>(x0) + 0.5, static_cast<double>(width()) - 0.5 - static_cast<double>(x0),
+                static_cast<double>(y0) + 0.5, static_cast<double>(height()) - 0.5 - static_cast<double>(y0)
+            };
+
+            double enter = 0;
+            double leave = 1;
+
+            for (int i = 0; i < 4; i++)
+            {
+                if (p[i] == 0)
+                {
+                    if (q[i] < 0)
+                        return false;
+                    continue;
+                }
+
+                const double t = q[i] / p[i];
+                if (p[i] < 0)
+                    enter = std::max(enter, t);
+                else
+                    leave = std::min(leave, t);
+            }
+
+            if (enter > leave)
+                return false;
+
+            const double steps = static_cast<double>(last);
+            first = std::max(0L, static_cast<long>(std::floor(enter * steps)) - 1);
+            last = std::min(last, static_cast<long>(std::ceil(leave * steps)) + 1);
+            return true;
+        }
+
+        /// @brief Appends the shortest SGR selecting a foreground color.
+        static auto select(std::string& out, const color& c) -> void
+        {
+            switch (c.kind)
+            {
+            case color::none:
+                out.append(table::sgr[fg::regular.value[0]].view());
+                break;
+
+            case color::indexed:
+                if (c.r < 8)
+                    out.append(table::sgr[30 + c.r].view());
+                else if (c.r < 16)
+                    out.append(table::sgr[90 + c.r - 8].view());
+                else
+                    out.append(table::fg[c.r].view());
+                break;
+
+            case color::direct:
+            {
+                char buf[max_length(fg::rgb(0, 0, 0))];
+                out.append(buf, ansi::render(fg::rgb(c.r, c.g, c.b), buf));
+                break;
+            }
+            }
+        }
+
+        /// @brief Width in cells.
+        std::size_t columns_;
+
+        /// @brief Height in cells.
+        std::size_t rows_;
+
+        /// @brief Dots of every cell.
+        std::vector<std::uint8_t> dots_;
+
+        /// @brief Color of every cell.
+        std::vector<color> colors_;
+
+        /// @brief Color of the following drawings.
+        color pen_;
+    };
+
+    /// @brief Renders a canvas to an output stream.
+    /// @param[out] os  Output stream.
+    /// @param[in]  obj Canvas.
+    /// @return The modified output stream reference.
+    inline auto operator<<(std::ostream& os, const canvas& obj) -> std::ostream&
+    {
+        std::string out;
+        obj.render(out);
+        return os.write(out.data(), static_cast<std::streamsize>(out.size()));
+    }
+}
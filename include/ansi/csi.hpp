@@ -6,7 +6,10 @@
 /// @copyright Copyright (c) 2024
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <ostream>
+#include <string_view>
 
 /// @brief ANSI Escape Codes.
 namespace ansi
@@ -50,6 +53,110 @@ namespace ansi
     using rgb = csi<5>;
 
 
+    /// @brief Renders a CSI value as decimal digits, usable at compile time.
+    /// @param[in]  n   Value.
+    /// @param[out] out Destination of at least 3 bytes.
+    /// @return Number of bytes written.
+    constexpr auto render(const byte n, char* const out) -> std::size_t
+    {
+        std::size_t size = 0;
+        if (n >= 100)
+            out[size++] = static_cast<char>('0' + n / 100);
+        if (n >= 10)
+            out[size++] = static_cast<char>('0' + n / 10 % 10);
+        out[size++] = static_cast<char>('0' + n % 10);
+        return size;
+    }
+
+    /// @brief Upper bound of the length of the textual ANSI escape code of a CSI object.
+    /// @tparam N Number of values.
+    /// @return Number of bytes.
+    template <std::size_t N>
+    constexpr auto max_length(const csi<N>&) -> std::size_t { return 3 + 4 * N; }
+
+    /// @brief Renders textual ANSI escape code of a CSI object, usable at compile time.
+    /// @tparam N Number of values.
+    /// @param[in]  obj CSI object.
+    /// @param[out] out Destination of at least @c max_length(obj) bytes.
+    /// @return Number of bytes written.
+    /// @see ansi::csi
+    template <std::size_t N>
+    constexpr auto render(const csi<N>& obj, char* const out) -> std::size_t
+    {
+        std::size_t size = 0;
+        out[size++] = '\x1b';
+        out[size++] = '[';
+
+        if constexpr (N > 0)
+            for (std::size_t i = 0; i < N; i++)
+            {
+                if (i > 0)
+                    out[size++] = ';';
+
+                size += ansi::render(obj.value[i], out + size);
+            }
+
+        out[size++] = obj.delim;
+        return size;
+    }
+
+
+    /// @brief Pre-rendered textual ANSI escape code.
+    struct rendered
+    {
+        /// @brief Sequence bytes, padded with zeros.
+        /// @details The longest sequence fits, so copying all of them and advancing by @c size is valid.
+        char data[11];
+
+        /// @brief Number of sequence bytes.
+        byte size;
+
+        /// @brief Sequence bytes.
+        /// @return View of the sequence.
+        constexpr auto view() const -> std::string_view { return {data, size}; }
+    };
+
+    /// @brief Read-only tables of pre-rendered SGR sequences.
+    namespace table
+    {
+        /// @brief Renders an SGR with one or three values.
+        /// @param[in] layer Extended color selector, 38, 48 or 58; zero for a single-valued SGR.
+        /// @param[in] value Code, or 8-bit color.
+        /// @return Rendered sequence.
+        constexpr auto render(const byte layer, const byte value) -> rendered
+        {
+            rendered r{};
+            r.size = static_cast<byte>(layer != 0 ? ansi::render(ansi::col{{layer, 5, value}, 'm'}, r.data) : ansi::render(ansi::sgr{{value}, 'm'}, r.data));
+            return r;
+        }
+
+        /// @brief Renders all 256 values of an SGR.
+        /// @param[in] layer Extended color selector, 38, 48 or 58; zero for a single-valued SGR.
+        /// @return Rendered sequences indexed by value.
+        constexpr auto render_all(const byte layer) -> std::array<rendered, 256>
+        {
+            std::array<rendered, 256> t{};
+            for (std::size_t i = 0; i < t.size(); i++)
+                t[i] = render(layer, static_cast<byte>(i));
+
+            return t;
+        }
+
+        /// @brief Single-valued SGR sequences, indexed by code.
+        /// @see ansi::sgr
+        constexpr inline std::array<rendered, 256> sgr = render_all(0);
+
+        /// @brief 8-bit foreground color sequences, indexed by color.
+        constexpr inline std::array<rendered, 256> fg = render_all(38);
+
+        /// @brief 8-bit background color sequences, indexed by color.
+        constexpr inline std::array<rendered, 256> bg = render_all(48);
+
+        /// @brief 8-bit underline color sequences, indexed by color.
+        constexpr inline std::array<rendered, 256> underline = render_all(58);
+    }
+
+
     /// @brief Creates textual ANSI escape code from a CSI object for an output stream.
     /// @tparam N Number of values.
     /// @param[out] os  Output stream.
@@ -59,15 +166,21 @@ namespace ansi
     template <std::size_t N>
     constexpr auto operator<<(std::ostream& os, const csi<N>& obj) -> std::ostream&
     {
-        os << "\x1b[";
-
-        if constexpr (N > 0)
-            os << static_cast<unsigned>(obj.value[0]);
+        if constexpr (N == 1)
+            if (obj.delim == 'm')
+                return os.write(table::sgr[obj.value[0]].data, table::sgr[obj.value[0]].size);
 
-        if constexpr (N > 1)
-            for (std::size_t i = 1; i < N; i++)
-                os << ';' << static_cast<unsigned>(obj.value[i]);
+        if constexpr (N == 3)
+            if (obj.delim == 'm' && obj.value[1] == 5)
+                switch (obj.value[0])
+                {
+                case 38: return os.write(table::fg[obj.value[2]].data, table::fg[obj.value[2]].size);
+                case 48: return os.write(table::bg[obj.value[2]].data, table::bg[obj.value[2]].size);
+                case 58: return os.write(table::underline[obj.value[2]].data, table::underline[obj.value[2]].size);
+                default: break;
+                }
 
-        return os << obj.delim;
+        char buf[3 + 4 * N];
+        return os.write(buf, static_cast<std::streamsize>(ansi::render(obj, buf)));
     }
 }
@@ -0,0 +1,29 @@
+/// @file parallel.hpp
+/// @author Danylo Marchenko (cdanymar)
+/// @brief Defines the thread fan-out shared by the converters that split their input into blocks.
+/// @version 1.0
+/// @date 2024-08-11
+/// @copyright Copyright (c) 2024
+#pragma once
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/// @brief Implementation details of the ANSI library.
+namespace ansi::detail
+{
+    /// @brief Runs a job for each index on its own thread, index zero on the calling one.
+    /// @param[in] count Number of indices.
+    /// @param[in] job   Callable taking an index.
+    template <typename Job>
+    auto parallel(const std::size_t count, const Job& job) -> void
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t i = 1; i < count; i++)
+            workers.emplace_back([&job, i] { job(i); });
+
+        if (count > 0)
+            job(0);
+    }
+}
@@ -0,0 +1,605 @@
+/// @file highlight.hpp
+/// @author Danylo Marchenko (cdanymar)
+/// @brief Defines a streaming filter that colors timestamps, levels, addresses, numbers, strings and keys in plain logs.
+/// @version 1.0
+/// @date 2024-08-11
+/// @copyright Copyright (c) 2024
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define ANSI_HIGHLIGHT_SSE2
+#endif
+
+#include "csi.hpp"
+#include "iomanip.hpp"
+
+/// @brief ANSI Escape Codes.
+namespace ansi
+{
+    /// @brief Styles of the tokens recognized by @c ansi::highlighter .
+    struct highlight_theme
+    {
+        /// @brief Renders manipulators into a style string.
+        /// @tparam N Numbers of values.
+        /// @param[in] manips Manipulators, e.g. @c fg::red and @c text::bold .
+        /// @return Concatenated sequences.
+        template <std::size_t... N>
+        static auto style(const csi<N>&... manips) -> std::string
+        {
+            std::ostringstream os;
+            ((os << manips), ...);
+            return os.str();
+        }
+
+        /// @brief Dates and times.
+        std::string timestamp = style(fg::cyan);
+
+        /// @brief @c FATAL, @c ERROR and similar levels.
+        std::string error = style(fg::red, text::bold);
+
+        /// @brief @c WARN and @c WARNING levels.
+        std::string warning = style(fg::yellow, text::bold);
+
+        /// @brief @c INFO and @c NOTICE levels.
+        std::string info = style(fg::green);
+
+        /// @brief @c DEBUG and @c TRACE levels.
+        std::string debug = style(fg::gray);
+
+        /// @brief IPv4 addresses with optional port.
+        std::string address = style(fg::magenta);
+
+        /// @brief Integer, decimal and hexadecimal numbers.
+        std::string number = style(fg::bright::indigo);
+
+        /// @brief Double-quoted strings.
+        std::string string = style(fg::bright::green);
+
+        /// @brief Keys of @c key=value pairs.
+        std::string key = style(fg::indigo);
+
+        /// @brief Sequence ending every token.
+        std::string end = style(reset);
+    };
+
+    /// @brief Streaming log highlighter.
+    /// @details Input is split into lines and each complete line is tokenized by a hand-written lexer; text between tokens
+    /// is copied in whole spans. Level names are only recognized where a log puts them: in the line prefix, made of
+    /// timestamps, numbers and bracketed words, in brackets, before a colon, or as the value of a @c level key. Runs of letters and the insides of strings are scanned 16 bytes at a time where SSE2 is
+    /// available. Output collects in a large buffer handed to the stream only when it fills up.
+    class highlighter
+    {
+    public:
+        /// @brief Creates a highlighter.
+        /// @param[out] os       Output stream.
+        /// @param[in]  theme    Token styles.
+        /// @param[in]  capacity Output buffer size in bytes.
+        explicit highlighter(std::ostream& os, highlight_theme theme = {}, const std::size_t capacity = 1 << 20)
+            : os_(&os), theme_(std::move(theme)), capacity_(capacity),
+              timestamp_(theme_.timestamp), error_(theme_.error), warning_(theme_.warning), info_(theme_.info),
+              debug_(theme_.debug), address_(theme_.address), number_(theme_.number), string_(theme_.string),
+              key_(theme_.key), end_(theme_.end)
+        {
+            out_.resize(capacity_ + capacity_ / 2);
+        }
+
+        highlighter(const highlighter&) = delete;
+        auto operator=(const highlighter&) -> highlighter& = delete;
+
+        /// @brief Flushes the remaining input and output.
+        ~highlighter() { finish(); }
+
+        /// @brief Highlights a chunk of input.
+        /// @details A trailing incomplete line is kept until the next chunk, unless it grows beyond the buffer size.
+        /// @param[in] chunk Input bytes.
+        auto feed(std::string_view chunk) -> void
+        {
+            if (!tail_.empty())
+            {
+                const std::size_t nl = chunk.find('\n');
+                if (nl == std::string_view::npos && tail_.size() + chunk.size() < capacity_)
+                {
+                    tail_.append(chunk);
+                    return;
+                }
+
+                const std::size_t take = nl == std::string_view::npos ? chunk.size() : nl + 1;
+                tail_.append(chunk.substr(0, take));
+                lex(tail_);
+                tail_.clear();
+                chunk.remove_prefix(take);
+            }
+
+            const std::size_t last = chunk.rfind('\n');
+            if (last == std::string_view::npos && chunk.size() < capacity_)
+            {
+                tail_.assign(chunk);
+                return;
+            }
+
+            const std::size_t body = last == std::string_view::npos ? chunk.size() : last + 1;
+            lex(chunk.substr(0, body));
+            tail_.assign(chunk.substr(body));
+
+            if (size_ >= capacity_)
+            {
+                os_->write(out_.data(), static_cast<std::streamsize>(size_));
+                size_ = 0;
+            }
+        }
+
+        /// @brief Highlights the trailing incomplete line and writes all output.
+        auto finish() -> void
+        {
+            if (!tail_.empty())
+            {
+                lex(tail_);
+                tail_.clear();
+            }
+
+            flush();
+        }
+
+        /// @brief Writes the output so far to the stream, keeping an incomplete line.
+        auto flush() -> void
+        {
+            os_->write(out_.data(), static_cast<std::streamsize>(size_));
+            os_->flush();
+            size_ = 0;
+        }
+
+    private:
+        /// @brief Theme entry, copied into the output with one fixed-size move when it is short enough.
+        struct mark
+        {
+            /// @brief Prepares an entry.
+            /// @param[in] text Sequence, must outlive the entry.
+            explicit mark(const std::string& text) : size(text.size()), text(text.size() > sizeof data ? &text : nullptr)
+            {
+                text.copy(data, std::min(size, sizeof data));
+            }
+
+            /// @brief Sequence, padded with zeros.
+            char data[32]{};
+
+            /// @brief Sequence length.
+            std::size_t size;
+
+            /// @brief Sequence longer than @c data , null otherwise.
+            const std::string* text;
+        };
+
+        /// @brief Byte classes.
+        enum : std::uint8_t
+        {
+            alpha = 1 << 0, ///< Letter.
+            digit = 1 << 1, ///< Decimal digit.
+            ident = 1 << 2, ///< Letter, digit, or one of @c _.- .
+            hex = 1 << 3 ///< Hexadecimal digit.
+        };
+
+        /// @brief Byte class table.
+        static constexpr std::array<std::uint8_t, 256> cls = []
+        {
+            std::array<std::uint8_t, 256> t{};
+
+            for (int c = 0; c < 256; c++)
+            {
+                if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+                    t[c] |= alpha | ident;
+                if (c >= '0' && c <= '9')
+                    t[c] |= digit | ident | hex;
+                if ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'))
+                    t[c] |= hex;
+                if (c == '_' || c == '.' || c == '-')
+                    t[c] |= ident;
+            }
+
+            return t;
+        }();
+
+        /// @brief Tests a byte class.
+        static auto is(const char c, const std::uint8_t mask) -> bool { return (cls[static_cast<unsigned char>(c)] & mask) != 0; }
+
+        /// @brief Skips letters.
+        static auto skip_alpha(const char* p, const char* const end) -> const char*
+        {
+#ifdef ANSI_HIGHLIGHT_SSE2
+            const __m128i lower_a = _mm_set1_epi8('a' - 1);
+            const __m128i lower_z = _mm_set1_epi8('z' + 1);
+            const __m128i case_bit = _mm_set1_epi8(0x20);
+
+            while (end - p >= 16)
+            {
+                const __m128i v = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), case_bit);
+                const __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(v, lower_a), _mm_cmplt_epi8(v, lower_z));
+                const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(letter)) ^ 0xFFFF;
+
+                if (mask != 0)
+                    return p + std::countr_zero(mask);
+
+                p += 16;
+            }
+#endif
+            while (p != end && is(*p, alpha))
+                ++p;
+
+            return p;
+        }
+
+        /// @brief Finds the closing quote, a backslash or the end of the line.
+        static auto find_quote(const char* p, const char* const end) -> const char*
+        {
+#ifdef ANSI_HIGHLIGHT_SSE2
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i newline = _mm_set1_epi8('\n');
+
+            while (end - p >= 16)
+            {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                const __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)), _mm_cmpeq_epi8(v, newline));
+                const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+
+                if (mask != 0)
+                    return p + std::countr_zero(mask);
+
+                p += 16;
+            }
+#endif
+            while (p != end && *p != '"' && *p != '\\' && *p != '\n')
+                ++p;
+
+            return p;
+        }
+
+        /// @brief Counts digits, at most @c max .
+        static auto digits(const char* p, const char* const end, const std::size_t max = SIZE_MAX) -> std::size_t
+        {
+            std::size_t n = 0;
+            while (p + n != end && n < max && is(p[n], digit))
+                n++;
+
+            return n;
+        }
+
+        /// @brief Tests for @c n digits followed by a separator.
+        static auto field(const char* p, const char* const end, const std::size_t n, const char sep) -> bool
+        {
+            return end - p > static_cast<std::ptrdiff_t>(n) && digits(p, end, n) == n && p[n] == sep;
+        }
+
+        /// @brief Matches @c HH:MM:SS with optional fraction.
+        static auto match_time(const char* p, const char* const end) -> const char*
+        {
+            if (!field(p, end, 2, ':') || !field(p + 3, end, 2, ':') || digits(p + 6, end, 2) != 2)
+                return nullptr;
+
+            p += 8;
+            if (p != end && (*p == '.' || *p == ',') && p + 1 != end && is(p[1], digit))
+                p += 1 + digits(p + 1, end);
+
+            return p;
+        }
+
+        /// @brief Matches a date with optional time and zone, or a time.
+        static auto match_timestamp(const char* p, const char* const end) -> const char*
+        {
+            if (!field(p, end, 4, '-') || !field(p + 5, end, 2, '-') || digits(p + 8, end, 2) != 2)
+                return match_time(p, end);
+
+            p += 10;
+            if (end - p < 9 || (*p != 'T' && *p != ' '))
+                return p;
+
+            const char* const time = match_time(p + 1, end);
+            if (!time)
+                return p;
+
+            p = time;
+            if (p != end && *p == 'Z')
+                return p + 1;
+
+            if (p != end && (*p == '+' || *p == '-') && digits(p + 1, end, 2) == 2)
+            {
+                const char* zone = p + 3;
+                if (zone != end && *zone == ':')
+                    zone++;
+
+                if (digits(zone, end, 2) == 2)
+                    return zone + 2;
+            }
+
+            return p;
+        }
+
+        /// @brief Matches an IPv4 address with optional port.
+        static auto match_address(const char* p, const char* const end) -> const char*
+        {
+            for (int part = 0; part < 4; part++)
+            {
+                if (part > 0)
+                {
+                    if (p == end || *p != '.')
+                        return nullptr;
+                    ++p;
+                }
+
+                const std::size_t n = digits(p, end, 4);
+                if (n == 0 || n > 3)
+                    return nullptr;
+                p += n;
+            }
+
+            if (p != end && *p == ':' && p + 1 != end && is(p[1], digit))
+                p += 1 + digits(p + 1, end);
+
+            return p;
+        }
+
+        /// @brief Matches a decimal or hexadecimal number.
+        static auto match_number(const char* p, const char* const end) -> const char*
+        {
+            if (end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X') && is(p[2], hex))
+            {
+                p += 2;
+                while (p != end && is(*p, hex))
+                    ++p;
+                return p;
+            }
+
+            p += digits(p, end);
+            if (p != end && *p == '.' && p + 1 != end && is(p[1], digit))
+                p += 1 + digits(p + 1, end);
+
+            return p;
+        }
+
+        /// @brief Packs up to 8 letters, upper-cased, into an integer.
+        static constexpr auto pack(const std::string_view word) -> std::uint64_t
+        {
+            std::uint64_t v = 0;
+            for (const char c : word)
+                v = v << 8 | static_cast<unsigned char>(c & ~0x20);
+
+            return v;
+        }
+
+        /// @brief Tests whether a key names the level of a line.
+        static auto level_key(const std::string_view key) -> bool
+        {
+            if (key.size() > 8)
+                return false;
+
+            const std::uint64_t v = pack(key);
+            return v == pack("LEVEL") || v == pack("LVL") || v == pack("SEVERITY");
+        }
+
+        /// @brief Finds the style of a level name.
+        auto level(const std::string_view word) const -> const mark*
+        {
+            if (word.size() < 3 || word.size() > 8)
+                return nullptr;
+
+            switch (pack(word))
+            {
+            case pack("ERROR"):
+            case pack("ERR"):
+            case pack("FATAL"):
+            case pack("CRIT"):
+            case pack("CRITICAL"):
+            case pack("PANIC"):
+            case pack("ALERT"):
+            case pack("EMERG"):
+                return &error_;
+
+            case pack("WARN"):
+            case pack("WARNING"):
+                return &warning_;
+
+            case pack("INFO"):
+            case pack("NOTICE"):
+                return &info_;
+
+            case pack("DEBUG"):
+            case pack("DBG"):
+            case pack("TRACE"):
+                return &debug_;
+
+            default:
+                return nullptr;
+            }
+        }
+
+        /// @brief Emits the plain span before a token, then the styled token.
+        /// @details Makes room once for all four parts; the theme entries may write up to their padded size.
+        auto token(const char*& plain, const char* const begin, const char* const end, const mark& style) -> void
+        {
+            const auto before = static_cast<std::size_t>(begin - plain);
+            const auto length = static_cast<std::size_t>(end - begin);
+            reserve(before + style.size + length + std::max(end_.size, sizeof end_.data));
+
+            char* o = out_.data() + size_;
+            std::memcpy(o, plain, before);
+            o = copy(o + before, style);
+            std::memcpy(o, begin, length);
+            o = copy(o + length, end_);
+            size_ = static_cast<std::size_t>(o - out_.data());
+            plain = end;
+        }
+
+        /// @brief Copies a theme entry.
+        /// @return End of the entry in the output.
+        static auto copy(char* const o, const mark& m) -> char*
+        {
+            if (m.text)
+                std::memcpy(o, m.text->data(), m.size);
+            else
+                std::memcpy(o, m.data, sizeof m.data);
+
+            return o + m.size;
+        }
+
+        /// @brief Tokenizes complete lines.
+        auto lex(const std::string_view text) -> void
+        {
+            const char* p = text.data();
+            const char* const end = p + text.size();
+            const char* plain = p;
+
+            // Whether the line prefix is still open, and where the value of a level key starts.
+            bool prefix = true;
+            const char* level_value = nullptr;
+
+            while (p != end)
+            {
+                const char c = *p;
+
+                if (is(c, alpha))
+                {
+                    const char* const word = p;
+                    const char* const letters = skip_alpha(p, end);
+                    p = letters;
+                    while (p != end && is(*p, ident))
+                        ++p;
+
+                    const bool opened = word != text.data() && (word[-1] == '[' || word[-1] == '<');
+
+                    if (p != end && *p == '=')
+                    {
+                        token(plain, word, p, key_);
+                        if (level_key({word, static_cast<std::size_t>(p - word)}))
+                            level_value = p + 1;
+                        ++p;
+                    }
+                    else if (letters == p || !is(*letters, alpha | digit))
+                    {
+                        const bool placed = prefix || word == level_value || (letters != end && *letters == ':') ||
+                            (opened && letters != end && (*letters == ']' || *letters == '>'));
+
+                        if (const mark* style = placed ? level({word, static_cast<std::size_t>(letters - word)}) : nullptr)
+                            token(plain, word, letters, *style);
+                    }
+
+                    prefix &= opened && p != end && (*p == ']' || *p == '>');
+                }
+                else if (is(c, digit))
+                {
+                    // The leading digits tell which of the longer forms can match at all.
+                    const std::size_t lead = digits(p, end, 5);
+                    const char next = p + lead != end ? p[lead] : '\0';
+
+                    const char* match = nullptr;
+                    const mark* style = &timestamp_;
+
+                    if ((lead == 4 && next == '-') || (lead == 2 && next == ':'))
+                        match = match_timestamp(p, end);
+
+                    if (!match && lead <= 3 && next == '.')
+                    {
+                        match = match_address(p, end);
+                        style = &address_;
+                    }
+
+                    if (!match)
+                    {
+                        match = match_number(p, end);
+                        style = &number_;
+                    }
+
+                    // A number glued to more than a short unit, e.g. a hash, stays plain.
+                    const char* tail = match;
+                    bool unit = true;
+                    while (tail != end && (is(*tail, alpha | digit) || *tail == '_'))
+                        unit &= is(*tail++, alpha);
+
+                    if (tail == match || (style == &number_ && unit && tail - match <= 3))
+                        token(plain, p, match, *style);
+
+                    p = tail;
+                }
+                else if (c == '"')
+                {
+                    const char* q = p + 1;
+
+                    for (;;)
+                    {
+                        q = find_quote(q, end);
+
+                        if (q != end && *q == '\\' && q + 1 != end && q[1] != '\n')
+                            q += 2;
+                        else
+                            break;
+                    }
+
+                    if (q != end && *q == '"')
+                    {
+                        token(plain, p, q + 1, string_);
+                        p = q + 1;
+                    }
+                    else p = q;
+
+                    prefix = false;
+                }
+                else
+                {
+                    prefix |= c == '\n';
+                    ++p;
+                }
+            }
+
+            put(plain, end - plain);
+        }
+
+        /// @brief Appends to the output buffer, growing it if a chunk had many tokens.
+        auto put(const char* s, const std::ptrdiff_t n) -> void
+        {
+            const auto len = static_cast<std::size_t>(n);
+
+            reserve(len);
+            std::memcpy(out_.data() + size_, s, len);
+            size_ += len;
+        }
+
+        /// @brief Makes room for more output, growing the buffer if a chunk had many tokens.
+        auto reserve(const std::size_t n) -> void
+        {
+            if (size_ + n > out_.size())
+                out_.resize(std::max(out_.size() * 2, size_ + n));
+        }
+
+        /// @brief Output stream.
+        std::ostream* os_;
+
+        /// @brief Token styles.
+        highlight_theme theme_;
+
+        /// @brief Output buffer size.
+        std::size_t capacity_;
+
+        /// @brief Theme entries ready to copy.
+        mark timestamp_, error_, warning_, info_, debug_, address_, number_, string_, key_, end_;
+
+        /// @brief Output buffer.
+        std::string out_;
+
+        /// @brief Number of pending bytes in the output buffer.
+        std::size_t size_ = 0;
+
+        /// @brief Incomplete line from the previous chunk.
+        std::string tail_;
+    };
+}
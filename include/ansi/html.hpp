@@ -0,0 +1,408 @@
+/// @file html.hpp
+/// @author Danylo Marchenko (cdanymar)
+/// @brief Defines a streaming converter from ANSI-styled text to HTML markup.
+/// @version 1.0
+/// @date 2024-08-11
+/// @copyright Copyright (c) 2024
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "csi.hpp"
+#include "detail/parallel.hpp"
+#include "parser.hpp"
+#include "style.hpp"
+
+/// @brief ANSI Escape Codes.
+namespace ansi
+{
+    /// @brief Looks up an 8-bit color.
+    /// @param[in] index Palette index.
+    /// @return Color as @c 0xRRGGBB, xterm defaults.
+    constexpr auto palette(const byte index) -> std::uint32_t
+    {
+        constexpr std::uint32_t basic[16] = {
+            0x000000, 0xCD0000, 0x00CD00, 0xCDCD00, 0x0000EE, 0xCD00CD, 0x00CDCD, 0xE5E5E5,
+            0x7F7F7F, 0xFF0000, 0x00FF00, 0xFFFF00, 0x5C5CFF, 0xFF00FF, 0x00FFFF, 0xFFFFFF
+        };
+
+        if (index < 16)
+            return basic[index];
+
+        if (index >= 232)
+        {
+            const std::uint32_t v = 8 + (index - 232) * 10;
+            return v << 16 | v << 8 | v;
+        }
+
+        const auto level = [](const unsigned v) -> std::uint32_t { return v == 0 ? 0 : 55 + v * 40; };
+        const unsigned i = index - 16;
+        return level(i / 36) << 16 | level(i / 6 % 6) << 8 | level(i % 6);
+    }
+
+    /// @brief Streaming ANSI to HTML converter.
+    /// @details Text is escaped and wrapped in @c span elements whose classes are defined by @c stylesheet(); RGB colors
+    /// become inline styles. A span is opened only before text and only when the style differs from the open one, so
+    /// consecutive SGRs and runs that end up with the same style merge. Sequences other than SGR, and carriage returns and
+    /// backspaces, are dropped. Memory use is bounded by the output buffer size: the buffer is written whenever it fills,
+    /// also in the middle of a chunk.
+    class to_html
+    {
+    public:
+        /// @brief Creates a converter.
+        /// @param[out] os       Output stream, receives markup without a surrounding element.
+        /// @param[in]  initial  Style in effect before the input.
+        /// @param[in]  capacity Output buffer size in bytes.
+        explicit to_html(std::ostream& os, const style& initial = {}, const std::size_t capacity = 1 << 20)
+            : os_(&os), capacity_(capacity), pen_(initial), parser_(*this)
+        {
+            out_.reserve(capacity_ + 256);
+        }
+
+        to_html(const to_html&) = delete;
+        auto operator=(const to_html&) -> to_html& = delete;
+
+        /// @brief Closes the open span and writes the remaining output.
+        ~to_html() { finish(); }
+
+        /// @brief Converts a chunk of input, which may end inside a sequence.
+        /// @param[in] chunk Input bytes.
+        auto feed(const std::string_view chunk) -> void
+        {
+            parser_.feed(chunk);
+
+            if (out_.size() >= capacity_)
+                flush();
+        }
+
+        /// @brief Closes the open span and writes the output.
+        /// @details Further input opens a new span as needed.
+        auto finish() -> void
+        {
+            if (open_ != style{})
+                out_ += "</span>";
+
+            open_ = {};
+            flush();
+        }
+
+        /// @brief Style in effect at the end of the input so far.
+        auto pen() const -> const style& { return pen_; }
+
+        /// @brief Builds the style sheet for the classes used in the markup.
+        /// @return CSS rules, scoped to elements of class @c ansi .
+        static auto stylesheet() -> std::string
+        {
+            std::string css =
+                ".ansi{color:var(--ansi-fg,#e5e5e5);background-color:var(--ansi-bg,#000)}"
+                ".ansi .B{font-weight:bold}.ansi .D{opacity:.6}.ansi .I{font-style:italic}"
+                ".ansi .U{text-decoration-line:underline}.ansi .W{text-decoration-line:underline;text-decoration-style:double}"
+                ".ansi .K{animation:ansi-blink 1s steps(1) infinite}.ansi .H{color:transparent}"
+                ".ansi .S{text-decoration-line:line-through}.ansi .O{text-decoration-line:overline}"
+                ".ansi .fr{color:var(--ansi-bg,#000)}.ansi .br{background-color:var(--ansi-fg,#e5e5e5)}"
+                "@keyframes ansi-blink{50%{opacity:0}}";
+
+            for (int i = 0; i < 256; i++)
+            {
+                const std::string hex = to_hex(palette(static_cast<byte>(i)));
+                css += ".ansi .f" + std::to_string(i) + "{color:" + hex + "}";
+                css += ".ansi .b" + std::to_string(i) + "{background-color:" + hex + "}";
+            }
+
+            return css;
+        }
+
+        /// @brief Converts a whole input using several threads.
+        /// @details The input is processed in windows of @c threads blocks cut after line feeds. A first parallel pass
+        /// reduces each block to its effect on the style, the styles at block starts are chained in order, and a second
+        /// parallel pass converts the blocks, which are then written in order. Sequences are assumed not to span lines.
+        /// @param[in]  input   Input bytes.
+        /// @param[out] os      Output stream.
+        /// @param[in]  threads Number of threads, hardware concurrency if zero.
+        /// @param[in]  block   Approximate block size in bytes.
+        static auto convert(std::string_view input, std::ostream& os, unsigned threads = 0, const std::size_t block = 1 << 22) -> void
+        {
+            if (threads == 0)
+                threads = std::max(1u, std::thread::hardware_concurrency());
+
+            style pen;
+
+            while (!input.empty())
+            {
+                std::vector<std::string_view> blocks;
+                while (blocks.size() < threads && !input.empty())
+                {
+                    std::size_t cut = std::min(block, input.size());
+                    if (cut < input.size())
+                    {
+                        const std::size_t nl = input.find('\n', cut);
+                        cut = nl == std::string_view::npos ? input.size() : nl + 1;
+                    }
+
+                    blocks.push_back(input.substr(0, cut));
+                    input.remove_prefix(cut);
+                }
+
+                std::vector<sgr_effect> effects(blocks.size());
+                detail::parallel(blocks.size(), [&](const std::size_t i) { effects[i] = effect(blocks[i]); });
+
+                std::vector<style> starts(blocks.size());
+                for (std::size_t i = 0; i < blocks.size(); i++)
+                {
+                    starts[i] = pen;
+                    pen = effects[i].apply(pen);
+                }
+
+                std::vector<std::ostringstream> outputs(blocks.size());
+                detail::parallel(blocks.size(), [&](const std::size_t i)
+                {
+                    to_html converter(outputs[i], starts[i], blocks[i].size() * 2);
+                    converter.feed(blocks[i]);
+                });
+
+                for (const std::ostringstream& out : outputs)
+                    os << out.view();
+            }
+
+            os.flush();
+        }
+
+    private:
+        friend class vt_parser<to_html>;
+
+        /// @brief Reduces a block of input to its effect on the style.
+        static auto effect(const std::string_view input) -> sgr_effect
+        {
+            sgr_collector c;
+            vt_parser<sgr_collector> parser(c);
+            parser.feed(input);
+            return c.effect;
+        }
+
+        /// @brief Formats a color as CSS.
+        static auto to_hex(const std::uint32_t rgb) -> std::string
+        {
+            constexpr char digits[] = "0123456789abcdef";
+            std::string s = "#000000";
+
+            for (int i = 0; i < 6; i++)
+                s[6 - i] = digits[rgb >> (i * 4) & 0xF];
+
+            return s;
+        }
+
+        /// @brief Escapes and writes a run of text, opening a span first if the style changed.
+        /// @details The text is escaped in slices that fit the output buffer, which is written whenever it fills, so a
+        /// long run does not grow it past its size.
+        auto print(std::string_view text) -> void
+        {
+            if (pen_ != open_)
+                reopen();
+
+            while (!text.empty())
+            {
+                if (out_.size() >= capacity_)
+                    flush();
+
+                // An escaped character takes at most five bytes.
+                const std::size_t n = std::min(text.size(), std::max<std::size_t>((capacity_ - out_.size()) / 5, 1));
+                escape(text.substr(0, n));
+                text.remove_prefix(n);
+            }
+        }
+
+        /// @brief Escapes and appends text to the output buffer.
+        auto escape(const std::string_view text) -> void
+        {
+            const char* p = text.data();
+            const char* const end = p + text.size();
+            const char* run = p;
+
+            for (; p != end; ++p)
+            {
+                const char* entity;
+
+                switch (*p)
+                {
+                case '&': entity = "&amp;"; break;
+                case '<': entity = "&lt;"; break;
+                case '>': entity = "&gt;"; break;
+                default: continue;
+                }
+
+                out_.append(run, p);
+                out_.append(entity);
+                run = p + 1;
+            }
+
+            out_.append(run, end);
+        }
+
+        /// @brief Keeps line feeds and tabs as text.
+        auto execute(const char c) -> void
+        {
+            if (c == '\n' || c == '\t')
+                print({&c, 1});
+        }
+
+        /// @brief Ignores escape sequences other than a CSI.
+        auto esc(char, char) -> void {}
+
+        /// @brief Ignores the start of an OSC, DCS, SOS, PM or APC string.
+        auto string_begin(char) -> void {}
+
+        /// @brief Ignores string bytes.
+        auto string_put(char) -> void {}
+
+        /// @brief Ignores the end of a string.
+        auto string_end() -> void {}
+
+        /// @brief Applies an SGR to the pen.
+        auto csi(const vt_params& p, const char final) -> void
+        {
+            if (final == 'm' && p.prefix == 0 && p.intermediate == 0)
+                pen_.apply(p.value, p.count);
+        }
+
+        /// @brief Closes the open span and opens one for the pen.
+        /// @details Writes straight into the output buffer, so a style change does not allocate.
+        auto reopen() -> void
+        {
+            if (open_ != style{})
+                out_ += "</span>";
+
+            open_ = pen_;
+            if (open_ == style{})
+                return;
+
+            color fg = open_.fg;
+            color bg = open_.bg;
+
+            out_ += "<span class=\"";
+            const std::size_t classes = out_.size();
+
+            if (open_.attrs & style::invert)
+            {
+                std::swap(fg, bg);
+                if (fg.kind == color::none)
+                    out_ += " fr";
+                if (bg.kind == color::none)
+                    out_ += " br";
+            }
+
+            constexpr struct
+            {
+                std::uint16_t attr;
+                const char* name;
+            } names[] = {
+                {style::bold, " B"}, {style::faint, " D"}, {style::italic, " I"}, {style::underline, " U"},
+                {style::double_underline, " W"}, {style::blink | style::blink_fast, " K"}, {style::conceal, " H"},
+                {style::strike, " S"}, {style::overline, " O"}
+            };
+
+            for (const auto& n : names)
+                if (open_.attrs & n.attr)
+                    out_ += n.name;
+
+            const auto indexed = [this](const char* prefix, const byte index)
+            {
+                char digits[4];
+                out_.append(prefix).append(digits, std::to_chars(digits, digits + sizeof digits, index).ptr);
+            };
+
+            if (fg.kind == color::indexed)
+                indexed(" f", fg.r);
+            if (bg.kind == color::indexed)
+                indexed(" b", bg.r);
+
+            if (out_.size() == classes)
+                out_.resize(classes - std::strlen(" class=\""));
+            else
+            {
+                out_.erase(classes, 1);
+                out_ += '"';
+            }
+
+            const std::size_t styles = out_.size();
+
+            if (fg.kind == color::direct)
+                append_hex(";color:", fg);
+            if (bg.kind == color::direct)
+                append_hex(";background-color:", bg);
+            if (open_.ul.kind != color::none)
+                append_hex(";text-decoration-color:", open_.ul);
+
+            // The line classes each set the same property, so a combination of lines is given in full.
+            const bool under = open_.attrs & (style::underline | style::double_underline);
+            const bool strike = open_.attrs & style::strike;
+            const bool over = open_.attrs & style::overline;
+            if (under + strike + over > 1)
+            {
+                out_ += ";text-decoration-line:";
+                out_ += under ? "underline " : "";
+                out_ += strike ? "line-through " : "";
+                out_ += over ? "overline " : "";
+                out_.pop_back();
+            }
+
+            if (out_.size() != styles)
+            {
+                out_.replace(styles, 1, " style=\"");
+                out_ += '"';
+            }
+
+            out_ += '>';
+
+            if (out_.size() >= capacity_)
+                flush();
+        }
+
+        /// @brief Appends a CSS property with a color value.
+        auto append_hex(const char* property, const color& c) -> void
+        {
+            constexpr char digits[] = "0123456789abcdef";
+            const std::uint32_t rgb = c.kind == color::indexed ? palette(c.r) : static_cast<std::uint32_t>(c.r << 16 | c.g << 8 | c.b);
+
+            char hex[7] = {'#'};
+            for (int i = 0; i < 6; i++)
+                hex[6 - i] = digits[rgb >> (i * 4) & 0xF];
+
+            out_.append(property).append(hex, sizeof hex);
+        }
+
+        /// @brief Hands the output buffer to the stream.
+        auto flush() -> void
+        {
+            os_->write(out_.data(), static_cast<std::streamsize>(out_.size()));
+            out_.clear();
+        }
+
+        /// @brief Output stream.
+        std::ostream* os_;
+
+        /// @brief Output buffer size.
+        std::size_t capacity_;
+
+        /// @brief Pending output.
+        std::string out_;
+
+        /// @brief Style selected by the input.
+        style pen_;
+
+        /// @brief Style of the open span, default if none is open.
+        style open_;
+
+        /// @brief Byte stream parser.
+        vt_parser<to_html> parser_;
+    };
+}
@@ -84,7 +84,7 @@ namespace ansi
         {
             /// @brief Erase mode specializations.
             /// @see ansi::byte
-            enum erase_mode final : byte
+            enum erase_mode : byte
             {
                 from_caret, ///< Erase from caret to the end.
                 to_caret, ///< Erase from the beginning to caret.
@@ -0,0 +1,732 @@
+/// @file optimize.hpp
+/// @author Danylo Marchenko (cdanymar)
+/// @brief Defines a streaming filter re-encoding escape sequences to fewer bytes with the same rendering.
+/// @version 1.0
+/// @date 2024-08-11
+/// @copyright Copyright (c) 2024
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "csi.hpp"
+#include "parser.hpp"
+#include "style.hpp"
+
+/// @brief ANSI Escape Codes.
+namespace ansi
+{
+    /// @brief Streaming escape sequence optimizer.
+    /// @details Tracks the style and the caret of the terminal the output goes to, and defers SGRs and caret moves until
+    /// something depends on them: SGRs in between merge into the shortest one, or vanish if they change nothing, and moves
+    /// in between merge into the shortest equivalent, relative or absolute. Parameters are written without leading
+    /// zeros or trailing defaults. Text, other sequences and strings pass through unchanged and in order.
+    ///
+    /// The output renders the same as the input provided that the terminal starts in the state the input expects and,
+    /// when the screen size is given, that it is the actual size. The style is unknown until the input resets it, so
+    /// SGRs before the first reset pass through as they are; SGRs with sub-parameters or codes outside @c ansi::style
+    /// make it unknown again. The caret is tracked only with a known screen size, and only until the input sets margins,
+    /// origin mode or no wrapping, or prints characters other than ASCII; moves are merged but not made relative after it.
+    class optimize
+    {
+    public:
+        /// @brief Creates an optimizer.
+        /// @param[out] os       Output stream.
+        /// @param[in]  rows     Screen height, zero if unknown.
+        /// @param[in]  columns  Screen width, zero if unknown.
+        /// @param[in]  capacity Output buffer size in bytes.
+        explicit optimize(std::ostream& os, const std::size_t rows = 0, const std::size_t columns = 0, const std::size_t capacity = 1 << 20)
+            : os_(&os), capacity_(capacity), rows_(static_cast<unsigned>(rows)), columns_(static_cast<unsigned>(columns)), parser_(*this)
+        {
+            out_.reserve(capacity_ + 256);
+        }
+
+        optimize(const optimize&) = delete;
+        auto operator=(const optimize&) -> optimize& = delete;
+
+        /// @brief Writes the deferred changes and the remaining output.
+        ~optimize() { flush(); }
+
+        /// @brief Filters a chunk of input, which may end inside a sequence.
+        /// @param[in] chunk Input bytes.
+        auto feed(const std::string_view chunk) -> void
+        {
+            in_ += chunk.size();
+            parser_.feed(chunk);
+
+            if (out_.size() >= capacity_)
+                write();
+        }
+
+        /// @brief Writes the deferred style and caret changes and the output so far.
+        /// @details Call when the input pauses, so the screen is up to date; merging continues with the following input.
+        auto flush() -> void
+        {
+            flush_move();
+            flush_style();
+            write();
+            os_->flush();
+        }
+
+        /// @brief Number of input bytes so far.
+        auto bytes_in() const -> std::size_t { return in_; }
+
+        /// @brief Number of output bytes so far.
+        auto bytes_out() const -> std::size_t { return written_ + out_.size(); }
+
+    private:
+        friend class vt_parser<optimize>;
+
+        /// @brief Writes the output buffer.
+        auto write() -> void
+        {
+            os_->write(out_.data(), static_cast<std::streamsize>(out_.size()));
+            written_ += out_.size();
+            out_.clear();
+        }
+
+        /// @brief Passes text through, tracking the caret.
+        auto print(const std::string_view text) -> void
+        {
+            flush_move();
+            flush_style();
+            out_.append(text);
+
+            if (columns_ == 0 || col_ == 0 || untracked_ ||
+                std::any_of(text.begin(), text.end(), [](const char c) { return static_cast<unsigned char>(c) >= 0x80; }))
+            {
+                row_ = col_ = 0;
+                wrap_ = false;
+                return;
+            }
+
+            // Most text fits on the line.
+            if (!wrap_ && text.size() <= columns_ - col_)
+            {
+                col_ += static_cast<unsigned>(text.size());
+                return;
+            }
+
+            for (std::size_t i = 0; i < text.size(); i++)
+            {
+                if (wrap_)
+                {
+                    col_ = 1;
+                    line_feed();
+                    wrap_ = false;
+                }
+
+                if (col_ < columns_)
+                    col_++;
+                else
+                    wrap_ = true;
+            }
+        }
+
+        /// @brief Passes a control character through, or defers it if it only moves the caret.
+        auto execute(const char c) -> void
+        {
+            switch (c)
+            {
+            case '\r':
+                if (!untracked_)
+                    return move(0, 1);
+                break;
+
+            case '\b':
+                if (!untracked_ && !wrap_ && columns_ != 0 && target_col() > 1)
+                    return move(0, target_col() - 1);
+                break;
+
+            case '\n':
+            case '\v':
+            case '\f':
+                // A line feed at the bottom scrolls in a line of the background color.
+                flush_move();
+                flush_background();
+                out_ += c;
+                // The terminal, or a tty translating newlines, may also return the caret.
+                if (wrap_ || col_ != 1)
+                    col_ = 0;
+                line_feed();
+                wrap_ = false;
+                return;
+
+            default:
+                break;
+            }
+
+            flush_move();
+            flush_style();
+            out_ += c;
+
+            if (c == '\b' || c == '\t' || c == '\r')
+            {
+                col_ = 0;
+                wrap_ = false;
+            }
+        }
+
+        /// @brief Passes an escape sequence through, tracking its effect on the caret.
+        auto esc(const char intermediate, const char final) -> void
+        {
+            flush_move();
+            flush_style();
+
+            out_ += '\x1b';
+            if (intermediate)
+                out_ += intermediate;
+            out_ += final;
+
+            if (intermediate)
+                return;
+
+            switch (final)
+            {
+            case 'c':
+                // Full reset: default style and modes, caret home, and the default style saved with the caret.
+                want_ = pen_ = saved_ = {};
+                known_ = saved_known_ = true;
+                untracked_ = false;
+                row_ = col_ = 1;
+                wrap_ = false;
+                break;
+
+            case 'D': line_feed(); wrap_ = false; break;
+            case 'E': line_feed(); col_ = untracked_ ? 0 : 1; wrap_ = false; break;
+            case 'M': row_ = untracked_ || rows_ == 0 ? 0 : row_ > 1 ? row_ - 1 : row_; wrap_ = false; break;
+            case '7': save(); break;
+            case '8': restore(); break;
+            default: break;
+            }
+        }
+
+        /// @brief Passes the start of a string through.
+        auto string_begin(const char introducer) -> void
+        {
+            flush_move();
+            flush_style();
+            out_ += '\x1b';
+            out_ += introducer;
+        }
+
+        /// @brief Passes a string byte through.
+        auto string_put(const char c) -> void
+        {
+            out_ += c;
+        }
+
+        /// @brief Passes the end of a string through.
+        auto string_end() -> void
+        {
+            out_ += '\x07';
+        }
+
+        /// @brief Merges an SGR or a caret move into the deferred changes, or passes another CSI through.
+        auto csi(const vt_params& p, const char final) -> void
+        {
+            if (p.prefix == 0 && p.intermediate == 0 && final == 'm')
+                return sgr(p);
+
+            if (p.prefix == 0 && p.intermediate == 0 && p.colons == 0)
+                switch (final)
+                {
+                case 'H':
+                case 'f': return move(clamp(p.get(0, 1), rows_), clamp(p.get(1, 1), columns_));
+                case 'G':
+                case '`': return move(0, clamp(p.get(0, 1), columns_));
+                case 'd': return move(clamp(p.get(0, 1), rows_), 0);
+                case 'A':
+                case 'F': return relative(p, final, target_row(), -1, rows_);
+                case 'B':
+                case 'E':
+                case 'e': return relative(p, final, target_row(), 1, rows_);
+                case 'C':
+                case 'a': return relative(p, final, target_col(), 1, columns_);
+                case 'D': return relative(p, final, target_col(), -1, columns_);
+
+                // Erasing, inserting and scrolling fill with the background color and keep the caret, but may reset a
+                // pending wrap; inserting and deleting lines may also go to the first column, depending on the terminal.
+                case 'J':
+                case 'K':
+                case 'X':
+                case '@':
+                case 'P':
+                case 'S':
+                case 'T':
+                case 'L':
+                case 'M':
+                    flush_move();
+                    flush_background();
+                    put(p, final);
+                    if (wrap_)
+                        row_ = col_ = 0;
+                    if (final == 'L' || final == 'M')
+                        col_ = 0;
+                    wrap_ = false;
+                    return;
+
+                case 's':
+                    flush_move();
+                    flush_style();
+                    put(p, final);
+                    save();
+                    return;
+
+                case 'u':
+                    flush_move();
+                    flush_style();
+                    put(p, final);
+                    restore();
+                    return;
+
+                case 'r':
+                    untracked_ = true;
+                    break;
+
+                default:
+                    break;
+                }
+
+            flush_move();
+            flush_style();
+            put(p, final);
+
+            if (p.prefix == '?' && (final == 'h' || final == 'l'))
+            {
+                for (std::size_t i = 0; i < p.count; i++)
+                    switch (p.value[i])
+                    {
+                    case 6: // Origin mode.
+                    case 7: // Wrapping.
+                    case 69: // Left and right margins.
+                        untracked_ = true;
+                        row_ = col_ = 0;
+                        break;
+
+                    case 47: // Alternate screen, some of them saving and restoring the caret and the style.
+                    case 1047:
+                    case 1048:
+                    case 1049:
+                        known_ = known_ && p.value[i] < 1048;
+                        row_ = col_ = 0;
+                        break;
+
+                    default:
+                        break;
+                    }
+
+                return;
+            }
+
+            // Line feed also returning the caret.
+            if (p.prefix == 0 && final == 'h' && std::find(p.value, p.value + p.count, 20) != p.value + p.count)
+                untracked_ = true;
+
+            // A soft reset sets the default style, also the one saved with the caret.
+            if (p.prefix == 0 && p.intermediate == '!' && final == 'p')
+            {
+                want_ = pen_ = saved_ = {};
+                known_ = saved_known_ = true;
+            }
+
+            // Anything else may move the caret.
+            row_ = col_ = 0;
+            wrap_ = false;
+        }
+
+        /// @brief Merges an SGR into the deferred style.
+        auto sgr(const vt_params& p) -> void
+        {
+            const bool reset = p.count == 0 || p.value[0] == 0;
+
+            if (!supported(p))
+            {
+                flush_move();
+                flush_style();
+                put(p, 'm');
+                known_ = false;
+                return;
+            }
+
+            if (!known_)
+            {
+                if (!reset)
+                {
+                    flush_move();
+                    put(p, 'm');
+                    return;
+                }
+
+                // The terminal style is unknown until the reset is written, which the next change does in full.
+                want_ = {};
+                pen_ = {};
+                pen_.attrs = 0xFFFF;
+                known_ = true;
+            }
+
+            want_.apply(p.value, p.count);
+        }
+
+        /// @brief SGR codes below 128 tracked by @c ansi::style , one bit each.
+        static constexpr std::uint64_t tracked[2] = {
+            0x3FFULL | 0x1FULL << 21 | 0x7FFULL << 27 | 0x1FFULL << 39 | 1ULL << 49 | 1ULL << 53 | 1ULL << 55 | 1ULL << 59,
+            0xFFULL << (90 - 64) | 0xFFULL << (100 - 64)};
+
+        /// @brief Tells whether an SGR only uses codes tracked by @c ansi::style .
+        static auto supported(const vt_params& p) -> bool
+        {
+            if (p.colons != 0 || p.count == vt_params::max)
+                return false;
+
+            for (std::size_t i = 0; i < p.count; i++)
+            {
+                const std::uint16_t v = p.value[i];
+
+                if (v == 38 || v == 48 || v == 58)
+                {
+                    if (i + 2 < p.count && p.value[i + 1] == color::indexed && p.value[i + 2] <= 255)
+                        i += 2;
+                    else if (i + 4 < p.count && p.value[i + 1] == color::direct && std::max({p.value[i + 2], p.value[i + 3], p.value[i + 4]}) <= 255)
+                        i += 4;
+                    else
+                        return false;
+                }
+                else if (v >= 128 || !(tracked[v >> 6] >> (v & 63) & 1))
+                    return false;
+            }
+
+            return true;
+        }
+
+        /// @brief Writes the deferred style.
+        auto flush_style() -> void
+        {
+            if (!known_ || want_ == pen_)
+                return;
+
+            // From the unknown style, the change is a full reset.
+            char buf[style::max_length];
+            const bool reset = pen_.attrs == 0xFFFF;
+            out_.append(buf, reset && want_ != style{} ? want_.render(buf) : want_.render(buf, pen_));
+            pen_ = want_;
+        }
+
+        /// @brief Writes the deferred style if the background color differs.
+        auto flush_background() -> void
+        {
+            if (known_ && (want_.bg != pen_.bg || pen_.attrs == 0xFFFF))
+                flush_style();
+        }
+
+        /// @brief Clamps a caret coordinate to the screen.
+        static auto clamp(const unsigned v, const unsigned size) -> unsigned { return size != 0 ? std::min(v, size) : v; }
+
+        /// @brief Row the caret is at once the deferred move is done, zero if unknown.
+        auto target_row() const -> unsigned { return to_row_ ? to_row_ : row_; }
+
+        /// @brief Column the caret is at once the deferred move is done, zero if unknown.
+        auto target_col() const -> unsigned { return to_col_ ? to_col_ : col_; }
+
+        /// @brief Defers a move.
+        /// @param[in] row    Row, zero to keep it.
+        /// @param[in] column Column, zero to keep it.
+        auto move(const unsigned row, const unsigned column) -> void
+        {
+            if (row)
+                to_row_ = row;
+            if (column)
+                to_col_ = column;
+
+            moving_ = true;
+        }
+
+        /// @brief Defers a relative move, or passes it through if the caret is not tracked.
+        auto relative(const vt_params& p, const char final, const unsigned from, const int direction, const unsigned size) -> void
+        {
+            const unsigned n = p.get(0, 1);
+            const bool next = final == 'E' || final == 'F';
+
+            if (untracked_ || from == 0 || size == 0)
+            {
+                flush_move();
+                put(p, final);
+
+                if (final == 'C' || final == 'D' || final == 'a')
+                    col_ = 0;
+                else
+                {
+                    row_ = 0;
+                    if (next)
+                        col_ = untracked_ ? 0 : 1;
+                }
+
+                wrap_ = false;
+                return;
+            }
+
+            const unsigned to = direction > 0 ? std::min(from + n, size) : from > n ? from - n : 1;
+
+            if (final == 'C' || final == 'D' || final == 'a')
+                move(0, to);
+            else
+                move(to, next ? 1 : 0);
+        }
+
+        /// @brief Tracks saving the caret, which also saves the style.
+        auto save() -> void
+        {
+            saved_ = pen_;
+            saved_known_ = known_;
+        }
+
+        /// @brief Tracks restoring the caret, which also restores the style.
+        auto restore() -> void
+        {
+            want_ = pen_ = saved_;
+            known_ = saved_known_;
+            row_ = col_ = 0;
+            wrap_ = false;
+        }
+
+        /// @brief Moves to the next line for a line feed, scrolling at the bottom.
+        auto line_feed() -> void
+        {
+            if (row_ != 0 && rows_ != 0 && !untracked_)
+                row_ = std::min(row_ + 1, rows_);
+            else
+                row_ = 0;
+        }
+
+        /// @brief Writes the deferred move as the shortest equivalent sequence.
+        auto flush_move() -> void
+        {
+            if (!moving_)
+                return;
+
+            const unsigned r = to_row_;
+            const unsigned c = to_col_;
+            moving_ = false;
+            to_row_ = to_col_ = 0;
+
+            // Ways to reach the row and the column separately, either may be empty.
+            std::string vertical[3];
+            std::size_t vs = 0;
+            std::string horizontal[5];
+            std::size_t hs = 0;
+
+            // Line feeds may also return the caret, so they only go with a move to an absolute column.
+            std::size_t feeds = std::size(vertical);
+            std::size_t forward = std::size(horizontal);
+
+            const bool tracked = !untracked_ && rows_ != 0 && columns_ != 0;
+
+            if (r == 0 || r == row_)
+                vertical[vs++] = "";
+            if (r != 0)
+            {
+                vertical[vs++] = sequence(r, 'd');
+                if (tracked && row_ != 0 && r != row_)
+                {
+                    // Line feeds do not scroll here, as the row is on the screen.
+                    if (r > row_ && r - row_ <= 3 && !wrap_)
+                    {
+                        feeds = vs;
+                        vertical[vs++] = std::string(r - row_, '\n');
+                    }
+                    else if (r > row_)
+                        vertical[vs++] = sequence(r - row_, 'B');
+                    else
+                        vertical[vs++] = sequence(row_ - r, 'A');
+                }
+            }
+
+            if (c == 0 || (c == col_ && !wrap_))
+                horizontal[hs++] = "";
+            if (c != 0)
+            {
+                horizontal[hs++] = sequence(c, 'G');
+                if (!untracked_ && c == 1)
+                    horizontal[hs++] = "\r";
+                if (tracked && col_ != 0 && c != col_)
+                {
+                    forward = hs;
+                    horizontal[hs++] = c > col_ ? sequence(c - col_, 'C') : sequence(col_ - c, 'D');
+                }
+            }
+
+            std::string best;
+            bool found = false;
+
+            const auto consider = [&](std::string candidate)
+            {
+                // A move to where the caret already is still resets a pending wrap.
+                if (candidate.empty() && wrap_)
+                    return;
+
+                if (!found || candidate.size() < best.size())
+                {
+                    best = std::move(candidate);
+                    found = true;
+                }
+            };
+
+            for (std::size_t i = 0; i < vs; i++)
+                for (std::size_t j = 0; j < hs; j++)
+                    if (i != feeds || (j != forward && (!horizontal[j].empty() || col_ == 1)))
+                        consider(vertical[i] + horizontal[j]);
+
+            const unsigned row = r ? r : row_;
+            const unsigned col = c ? c : col_;
+
+            if (row != 0 && col != 0)
+            {
+                char buf[24] = {'\x1b', '['};
+                char* e = buf + 2;
+                if (row != 1)
+                    e = std::to_chars(e, buf + sizeof buf - 2, row).ptr;
+                if (col != 1)
+                {
+                    *e++ = ';';
+                    e = std::to_chars(e, buf + sizeof buf - 1, col).ptr;
+                }
+                *e++ = 'H';
+                consider(std::string(buf, e));
+
+                if (tracked && row_ != 0 && c == 1 && r != 0 && r != row_)
+                    consider(r > row_ ? sequence(r - row_, 'E') : sequence(row_ - r, 'F'));
+            }
+
+            out_ += best;
+
+            if (r)
+                row_ = r;
+            if (c)
+                col_ = c;
+            wrap_ = false;
+        }
+
+        /// @brief Formats a CSI with one parameter, omitted if it is 1.
+        static auto sequence(const unsigned n, const char final) -> std::string
+        {
+            char buf[24] = {'\x1b', '['};
+            char* e = buf + 2;
+            if (n != 1)
+                e = std::to_chars(e, buf + sizeof buf - 1, n).ptr;
+            *e++ = final;
+            return {buf, e};
+        }
+
+        /// @brief Writes a CSI in its shortest form.
+        /// @details For sequences whose missing parameters mean the default, zero parameters and trailing ones are omitted,
+        /// as is a single 1 where that is the default; a lone SGR reset is omitted. Sequences with a private marker, an
+        /// intermediate byte or sub-parameters, and other SGRs, are written with all their parameters.
+        auto put(const vt_params& p, const char final) -> void
+        {
+            constexpr std::string_view zero_default = "ABCDEFGHJKLMPSTXZ@`abdef";
+            constexpr std::string_view one_default = "ABCDEFGHLMPSTXZ@`abdef";
+
+            out_ += "\x1b[";
+            if (p.prefix)
+                out_ += p.prefix;
+
+            const bool plain = p.prefix == 0 && p.intermediate == 0 && p.colons == 0;
+            const bool elide = plain && zero_default.find(final) != std::string_view::npos;
+            std::size_t count = p.count;
+
+            if (elide)
+            {
+                while (count > 0 && p.value[count - 1] == 0)
+                    count--;
+
+                if (count == 1 && p.value[0] == 1 && one_default.find(final) != std::string_view::npos)
+                    count = 0;
+            }
+            else if (plain && final == 'm' && count == 1 && p.value[0] == 0)
+                count = 0;
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                if (i > 0)
+                    out_ += p.colons & (1 << (i - 1)) ? ':' : ';';
+
+                if (!elide || p.value[i] != 0)
+                {
+                    char digits[8];
+                    out_.append(digits, std::to_chars(digits, digits + sizeof digits, p.value[i]).ptr);
+                }
+            }
+
+            if (p.intermediate)
+                out_ += p.intermediate;
+            out_ += final;
+        }
+
+        /// @brief Output stream.
+        std::ostream* os_;
+
+        /// @brief Output buffer size.
+        std::size_t capacity_;
+
+        /// @brief Pending output.
+        std::string out_;
+
+        /// @brief Bytes written to the output stream.
+        std::size_t written_ = 0;
+
+        /// @brief Bytes of input.
+        std::size_t in_ = 0;
+
+        /// @brief Screen height, zero if unknown.
+        unsigned rows_;
+
+        /// @brief Screen width, zero if unknown.
+        unsigned columns_;
+
+        /// @brief Style selected by the input.
+        style want_;
+
+        /// @brief Style of the terminal; all attributes set if only known to be reset by the next change.
+        style pen_;
+
+        /// @brief Whether the terminal style is known.
+        bool known_ = false;
+
+        /// @brief Style saved with the caret.
+        style saved_;
+
+        /// @brief Whether the style saved with the caret is known.
+        bool saved_known_ = false;
+
+        /// @brief Caret row, 1-based, zero if unknown.
+        unsigned row_ = 0;
+
+        /// @brief Caret column, 1-based, zero if unknown.
+        unsigned col_ = 0;
+
+        /// @brief Whether the caret is past the last column, wrapping before the next character.
+        bool wrap_ = false;
+
+        /// @brief Whether margins, origin mode or no wrapping may be set, so that moves are only merged.
+        bool untracked_ = false;
+
+        /// @brief Whether a move is deferred.
+        bool moving_ = false;
+
+        /// @brief Deferred row, zero to keep it.
+        unsigned to_row_ = 0;
+
+        /// @brief Deferred column, zero to keep it.
+        unsigned to_col_ = 0;
+
+        /// @brief Byte stream parser.
+        vt_parser<optimize> parser_;
+    };
+}
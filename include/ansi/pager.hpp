@@ -0,0 +1,599 @@
+/// @file pager.hpp
+/// @author Danylo Marchenko (cdanymar)
+/// @brief Defines a pager engine over a memory-mapped file, rendering only the visible lines with their styles.
+/// @version 1.0
+/// @date 2024-08-11
+/// @copyright Copyright (c) 2024
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "csi.hpp"
+#include "detail/parallel.hpp"
+#include "iomanip.hpp"
+#include "parser.hpp"
+#include "style.hpp"
+
+/// @brief ANSI Escape Codes.
+namespace ansi
+{
+    /// @brief Pager engine.
+    /// @details Maps a file into memory and indexes it on a background thread: the file is split into one block per
+    /// thread, and every block is scanned in parallel for line feeds and for its effect on the style. The index keeps the
+    /// offset of every @c stride -th line and a sparse table of styles at line starts, about @c interval bytes apart, so
+    /// its size stays a small fraction of the file. Positions are byte offsets of line starts: moving by a few lines and
+    /// jumping to the end scan the mapped bytes directly and work before the index is ready, while going to a line number
+    /// needs the index. Sequences are assumed not to span lines. The pager needs the platform headers for mapping files,
+    /// so it is not part of @c <cansi> nor of the module and is included on its own as @c "ansi/pager.hpp".
+    class pager
+    {
+    public:
+        /// @brief Number of lines between indexed line offsets.
+        static constexpr std::size_t stride = 64;
+
+        /// @brief Maps a file and starts indexing it.
+        /// @param[in] path     File path.
+        /// @param[in] threads  Number of indexing threads, hardware concurrency if zero.
+        /// @param[in] interval Approximate distance in bytes between style checkpoints.
+        /// @throw std::system_error If the file cannot be opened or mapped.
+        explicit pager(const char* path, unsigned threads = 0, const std::size_t interval = 1 << 16) : interval_(interval)
+        {
+            map(path);
+
+            if (threads == 0)
+                threads = std::max(1u, std::thread::hardware_concurrency());
+
+            indexer_ = std::jthread([this, threads](const std::stop_token stop) { index(stop, threads); });
+        }
+
+        pager(const pager&) = delete;
+        auto operator=(const pager&) -> pager& = delete;
+
+        /// @brief Stops indexing and unmaps the file.
+        ~pager()
+        {
+            indexer_.request_stop();
+            if (indexer_.joinable())
+                indexer_.join();
+
+            unmap();
+        }
+
+        /// @brief File contents.
+        auto text() const -> std::string_view { return {data_, size_}; }
+
+        /// @brief Tells whether the index is complete.
+        auto ready() const -> bool { return ready_.load(std::memory_order_acquire); }
+
+        /// @brief Blocks until the index is complete.
+        auto wait() const -> void { ready_.wait(false, std::memory_order_acquire); }
+
+        /// @brief Number of lines, zero until the index is ready.
+        auto lines() const -> std::size_t { return ready() ? count_ : 0; }
+
+        /// @brief Finds a line by number.
+        /// @param[in] n Line number, 0-based, clamped to the last line.
+        /// @return Offset of the line start, zero until the index is ready.
+        auto line(const std::size_t n) const -> std::size_t
+        {
+            if (!ready() || count_ == 0)
+                return 0;
+
+            const std::size_t target = std::min(n, count_ - 1);
+            return forward(offsets_[target / stride], target % stride);
+        }
+
+        /// @brief Moves down by lines, stopping at the last line.
+        /// @param[in] offset Line start.
+        /// @param[in] n      Number of lines.
+        /// @return Offset of the line start reached.
+        auto forward(std::size_t offset, std::size_t n) const -> std::size_t
+        {
+            for (; n > 0 && offset < size_; n--)
+            {
+                const auto* nl = static_cast<const char*>(std::memchr(data_ + offset, '\n', size_ - offset));
+                if (!nl || nl + 1 == data_ + size_)
+                    break;
+
+                offset = static_cast<std::size_t>(nl + 1 - data_);
+            }
+
+            return offset;
+        }
+
+        /// @brief Moves up by lines, stopping at the first line.
+        /// @param[in] offset Line start.
+        /// @param[in] n      Number of lines.
+        /// @return Offset of the line start reached.
+        auto backward(std::size_t offset, std::size_t n) const -> std::size_t
+        {
+            for (; n > 0 && offset > 0; n--)
+                offset = start_of(offset - 1);
+
+            return offset;
+        }
+
+        /// @brief Finds the top line of the last page.
+        /// @param[in] rows Page height.
+        /// @return Offset of the line start.
+        auto end(const std::size_t rows) const -> std::size_t
+        {
+            return size_ == 0 ? 0 : backward(start_of(size_ - 1), rows > 0 ? rows - 1 : 0);
+        }
+
+        /// @brief Style in effect at a line start.
+        /// @details Replays the sequences after the nearest checkpoint. Until the index is ready it replays them from the
+        /// last SGR reset before the line instead, which is slower the further back that reset is.
+        /// @param[in] offset Line start.
+        /// @return Style.
+        auto style_at(const std::size_t offset) const -> style
+        {
+            std::size_t from = 0;
+            style pen;
+
+            if (ready())
+            {
+                const auto it = std::upper_bound(checkpoints_.begin(), checkpoints_.end(), offset,
+                    [](const std::size_t o, const checkpoint& c) { return o < c.offset; });
+
+                from = std::prev(it)->offset;
+                pen = std::prev(it)->pen;
+            }
+            else
+                from = last_reset(offset);
+
+            return replay(pen, {data_ + from, offset - from});
+        }
+
+        /// @brief Renders a page.
+        /// @details Starts at the home position and draws each line clipped to the width, with its style carried over from
+        /// the lines before it, then erases the rest of the row. Rows past the last line are erased. Sequences other than
+        /// SGR in the file are dropped, tabs are expanded and other control characters are dropped.
+        /// @param[out] out     String to append to, reused between pages to avoid allocations.
+        /// @param[in]  top     Offset of the first line start.
+        /// @param[in]  rows    Page height.
+        /// @param[in]  columns Page width.
+        auto render(std::string& out, std::size_t top, const std::size_t rows, const std::size_t columns) const -> void
+        {
+            row_renderer r{{}, &out, style_at(top), columns, 0};
+            vt_parser<row_renderer> parser(r);
+            bool more = top < size_;
+
+            put(out, caret::home());
+
+            for (std::size_t i = 0; i < rows; i++)
+            {
+                if (i > 0)
+                    put(out, line::next());
+
+                if (more)
+                {
+                    const auto* nl = static_cast<const char*>(std::memchr(data_ + top, '\n', size_ - top));
+                    const std::size_t stop = nl ? static_cast<std::size_t>(nl - data_) : size_;
+
+                    char s[style::max_length];
+                    out.append(s, r.pen.render(s));
+
+                    r.column = 0;
+                    parser.feed({data_ + top, stop - top});
+                    parser.reset();
+
+                    top = stop + 1;
+                    more = top < size_;
+                }
+
+                put(out, reset);
+                put(out, erase::line(erase::from_caret));
+            }
+        }
+
+    private:
+        /// @brief Style at a line start.
+        struct checkpoint
+        {
+            /// @brief Line start.
+            std::size_t offset;
+
+            /// @brief Style in effect there.
+            style pen;
+        };
+
+        /// @brief Scan of one index block.
+        struct block
+        {
+            /// @brief First byte, a line start.
+            std::size_t begin;
+
+            /// @brief One past the last byte.
+            std::size_t end;
+
+            /// @brief Number of line feeds.
+            std::size_t newlines = 0;
+
+            /// @brief Line starts within the block, with the effect of the block up to each of them.
+            std::vector<std::pair<std::size_t, sgr_effect>> marks;
+
+            /// @brief Effect of the whole block.
+            sgr_effect total;
+
+            /// @brief Every @c stride -th line start within the block.
+            std::vector<std::size_t> offsets;
+        };
+
+        /// @brief Parser callbacks tracking the style.
+        struct tracker : vt_handler
+        {
+            /// @brief Style in effect.
+            style pen;
+
+            /// @brief Applies an SGR.
+            auto csi(const vt_params& p, const char final) -> void
+            {
+                if (final == 'm' && p.prefix == 0 && p.intermediate == 0)
+                    pen.apply(p.value, p.count);
+            }
+        };
+
+        /// @brief Parser callbacks drawing one row.
+        struct row_renderer : vt_handler
+        {
+            /// @brief Output.
+            std::string* out;
+
+            /// @brief Style in effect.
+            style pen;
+
+            /// @brief Row width.
+            std::size_t columns;
+
+            /// @brief Cells drawn so far.
+            std::size_t column;
+
+            /// @brief Appends the characters that fit, counting one cell per code point.
+            auto print(const std::string_view text) -> void
+            {
+                for (const char c : text)
+                {
+                    if ((static_cast<unsigned char>(c) & 0xC0) != 0x80)
+                    {
+                        if (column >= columns)
+                            return;
+
+                        column++;
+                    }
+
+                    *out += c;
+                }
+            }
+
+            /// @brief Expands tabs, drops other control characters.
+            auto execute(const char c) -> void
+            {
+                if (c != '\t')
+                    return;
+
+                const std::size_t to = std::min(columns, (column / 8 + 1) * 8);
+                out->append(to - std::min(to, column), ' ');
+                column = std::max(column, to);
+            }
+
+            /// @brief Applies an SGR, passing it on while the row has room.
+            /// @details Sub-parameter separators are kept, so that e.g. a curly underline stays one.
+            auto csi(const vt_params& p, const char final) -> void
+            {
+                if (final != 'm' || p.prefix != 0 || p.intermediate != 0)
+                    return;
+
+                pen.apply(p.value, p.count);
+
+                if (column >= columns)
+                    return;
+
+                *out += "\x1b[";
+                for (std::size_t i = 0; i < p.count; i++)
+                {
+                    if (i > 0)
+                        *out += p.colons & (1 << (i - 1)) ? ':' : ';';
+
+                    char digits[8];
+                    out->append(digits, std::to_chars(digits, digits + sizeof digits, p.value[i]).ptr);
+                }
+                *out += 'm';
+            }
+        };
+
+        /// @brief Appends a CSI.
+        template <std::size_t N>
+        static auto put(std::string& out, const csi<N>& obj) -> void
+        {
+            char buf[3 + 4 * N];
+            out.append(buf, ansi::render(obj, buf));
+        }
+
+        /// @brief Applies the SGRs in a run of bytes to a style.
+        static auto replay(const style& pen, const std::string_view bytes) -> style
+        {
+            tracker t;
+            t.pen = pen;
+
+            vt_parser<tracker> parser(t);
+            parser.feed(bytes);
+            return t.pen;
+        }
+
+        /// @brief Finds the last SGR reset before an offset.
+        /// @details An SGR whose first parameter is zero or empty clears the style before anything else, so replaying from
+        /// it needs no earlier state.
+        /// @return Offset of the sequence, zero if there is none.
+        auto last_reset(const std::size_t offset) const -> std::size_t
+        {
+            const std::string_view text(data_, offset);
+            std::size_t at = text.rfind("\x1b[");
+
+            while (at != std::string_view::npos)
+            {
+                const std::string_view rest = text.substr(at + 2, 2);
+                if (rest.starts_with('m') || rest.starts_with(';') || rest == "0m" || rest == "0;")
+                    return at;
+
+                at = at > 0 ? text.rfind("\x1b[", at - 1) : std::string_view::npos;
+            }
+
+            return 0;
+        }
+
+        /// @brief Finds the start of the line holding a byte.
+        auto start_of(std::size_t pos) const -> std::size_t
+        {
+            while (pos > 0 && data_[pos - 1] != '\n')
+                pos--;
+
+            return pos;
+        }
+
+        /// @brief Finds the first line start at or after an offset.
+        auto next_line(const std::size_t offset) const -> std::size_t
+        {
+            if (offset == 0 || offset >= size_ || data_[offset - 1] == '\n')
+                return std::min(offset, size_);
+
+            const auto* nl = static_cast<const char*>(std::memchr(data_ + offset, '\n', size_ - offset));
+            return nl ? static_cast<std::size_t>(nl + 1 - data_) : size_;
+        }
+
+        /// @brief Builds the index.
+        auto index(const std::stop_token stop, const unsigned threads) -> void
+        {
+            std::vector<block> blocks;
+            for (std::size_t begin = 0; begin < size_;)
+            {
+                const std::size_t end = next_line(std::max(begin + 1, size_ / threads * (blocks.size() + 1)));
+                blocks.push_back({begin, end, 0, {}, {}, {}});
+                begin = end;
+            }
+
+            // Line feeds and the effect up to every checkpoint, which falls on the first line start past each interval.
+            detail::parallel(blocks.size(), [&](const std::size_t i)
+            {
+                block& b = blocks[i];
+                sgr_collector c;
+                vt_parser<sgr_collector> parser(c);
+
+                for (std::size_t at = b.begin; at < b.end && !stop.stop_requested();)
+                {
+                    const std::size_t next = std::min(next_line(at + interval_), b.end);
+                    const std::string_view part(data_ + at, next - at);
+
+                    b.newlines += static_cast<std::size_t>(std::count(part.begin(), part.end(), '\n'));
+                    parser.feed(part);
+
+                    if (next < b.end)
+                        b.marks.emplace_back(next, c.effect);
+
+                    at = next;
+                }
+
+                b.total = c.effect;
+            });
+
+            if (stop.stop_requested())
+                return;
+
+            // Styles chained in order, and the number of the first line of every block.
+            std::vector<std::size_t> first(blocks.size());
+            checkpoints_.push_back({0, {}});
+            style pen;
+            std::size_t lines = 0;
+
+            for (std::size_t i = 0; i < blocks.size(); i++)
+            {
+                first[i] = lines;
+                lines += blocks[i].newlines;
+
+                if (i > 0)
+                    checkpoints_.push_back({blocks[i].begin, pen});
+                for (const auto& [offset, effect] : blocks[i].marks)
+                    checkpoints_.push_back({offset, effect.apply(pen)});
+
+                pen = blocks[i].total.apply(pen);
+            }
+
+            // Offsets of every stride-th line, now that the line numbers of the blocks are known.
+            detail::parallel(blocks.size(), [&](const std::size_t i)
+            {
+                block& b = blocks[i];
+                std::size_t n = first[i];
+                std::size_t at = b.begin;
+
+                while (at < b.end && !stop.stop_requested())
+                {
+                    if (n % stride == 0)
+                        b.offsets.push_back(at);
+
+                    const auto* nl = static_cast<const char*>(std::memchr(data_ + at, '\n', b.end - at));
+                    if (!nl)
+                        break;
+
+                    at = static_cast<std::size_t>(nl + 1 - data_);
+                    n++;
+                }
+            });
+
+            if (stop.stop_requested())
+                return;
+
+            for (const block& b : blocks)
+                offsets_.insert(offsets_.end(), b.offsets.begin(), b.offsets.end());
+
+            count_ = lines + (size_ > 0 && data_[size_ - 1] != '\n' ? 1 : 0);
+            if (offsets_.empty())
+                offsets_.push_back(0);
+
+            ready_.store(true, std::memory_order_release);
+            ready_.notify_all();
+        }
+
+#ifdef _WIN32
+        /// @brief Maps a file.
+        auto map(const char* path) -> void
+        {
+            file_ = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file_ == INVALID_HANDLE_VALUE)
+                throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), path);
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(file_, &size))
+            {
+                const auto error = static_cast<int>(GetLastError());
+                unmap();
+                throw std::system_error(error, std::system_category(), path);
+            }
+
+            size_ = static_cast<std::size_t>(size.QuadPart);
+            if (size_ == 0)
+                return;
+
+            mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping_)
+                data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+
+            if (!data_)
+            {
+                const auto error = static_cast<int>(GetLastError());
+                unmap();
+                throw std::system_error(error, std::system_category(), path);
+            }
+        }
+
+        /// @brief Unmaps the file.
+        auto unmap() -> void
+        {
+            if (data_)
+                UnmapViewOfFile(data_);
+            if (mapping_)
+                CloseHandle(mapping_);
+            if (file_ != INVALID_HANDLE_VALUE)
+                CloseHandle(file_);
+
+            data_ = nullptr;
+            mapping_ = nullptr;
+            file_ = INVALID_HANDLE_VALUE;
+        }
+
+        /// @brief File handle.
+        HANDLE file_ = INVALID_HANDLE_VALUE;
+
+        /// @brief File mapping handle.
+        HANDLE mapping_ = nullptr;
+#else
+        /// @brief Maps a file.
+        auto map(const char* path) -> void
+        {
+            const int fd = ::open(path, O_RDONLY);
+            if (fd < 0)
+                throw std::system_error(errno, std::generic_category(), path);
+
+            struct stat info{};
+            if (::fstat(fd, &info) != 0)
+            {
+                const int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), path);
+            }
+
+            size_ = static_cast<std::size_t>(info.st_size);
+            if (size_ > 0)
+            {
+                void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p == MAP_FAILED)
+                {
+                    const int error = errno;
+                    ::close(fd);
+                    throw std::system_error(error, std::generic_category(), path);
+                }
+
+                data_ = static_cast<const char*>(p);
+            }
+
+            ::close(fd);
+        }
+
+        /// @brief Unmaps the file.
+        auto unmap() -> void
+        {
+            if (data_)
+                ::munmap(const_cast<char*>(data_), size_);
+
+            data_ = nullptr;
+        }
+#endif
+
+        /// @brief Mapped bytes, null if the file is empty.
+        const char* data_ = nullptr;
+
+        /// @brief File size.
+        std::size_t size_ = 0;
+
+        /// @brief Approximate distance between checkpoints.
+        std::size_t interval_;
+
+        /// @brief Offsets of every @c stride -th line.
+        std::vector<std::size_t> offsets_;
+
+        /// @brief Styles at line starts, sorted by offset.
+        std::vector<checkpoint> checkpoints_;
+
+        /// @brief Number of lines.
+        std::size_t count_ = 0;
+
+        /// @brief Whether the index is complete.
+        std::atomic<bool> ready_ = false;
+
+        /// @brief Indexing thread, declared last to start after every other member is initialized.
+        std::jthread indexer_;
+    };
+}
@@ -0,0 +1,337 @@
+/// @file parser.hpp
+/// @author Danylo Marchenko (cdanymar)
+/// @brief Defines a table-driven parser splitting a byte stream into text, control characters and escape sequences.
+/// @version 1.0
+/// @date 2024-08-11
+/// @copyright Copyright (c) 2024
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "csi.hpp"
+
+/// @brief ANSI Escape Codes.
+namespace ansi
+{
+    /// @brief Parameters of a parsed CSI.
+    struct vt_params
+    {
+        /// @brief Maximum number of parameters kept, the rest are dropped.
+        static constexpr std::size_t max = 16;
+
+        /// @brief Parameter values, missing ones are zero.
+        std::uint16_t value[max];
+
+        /// @brief Number of parameters.
+        std::size_t count;
+
+        /// @brief Bit @c i is set when parameter @c i is followed by a colon, a sub-parameter separator, not a semicolon.
+        std::uint16_t colons;
+
+        /// @brief Private marker, one of @c <=>? , or zero.
+        char prefix;
+
+        /// @brief Last intermediate byte, or zero.
+        char intermediate;
+
+        /// @brief Reads a parameter.
+        /// @param[in] i   Parameter index.
+        /// @param[in] def Value used when the parameter is missing or zero.
+        /// @return Parameter value.
+        constexpr auto get(const std::size_t i, const std::uint16_t def) const -> std::uint16_t
+        {
+            return i < count && value[i] != 0 ? value[i] : def;
+        }
+    };
+
+    /// @brief Parser callbacks that do nothing.
+    /// @details Handlers derive from it and hide the callbacks they are interested in; calls are resolved statically.
+    struct vt_handler
+    {
+        /// @brief Receives a run of printable bytes, UTF-8 encoded.
+        constexpr auto print(std::string_view) -> void {}
+
+        /// @brief Receives a C0 control character.
+        constexpr auto execute(char) -> void {}
+
+        /// @brief Receives an escape sequence other than a CSI.
+        constexpr auto esc(char /*intermediate*/, char /*final*/) -> void {}
+
+        /// @brief Receives a CSI.
+        constexpr auto csi(const vt_params&, char /*final*/) -> void {}
+
+        /// @brief Receives the introducer of an OSC, DCS, SOS, PM or APC string.
+        constexpr auto string_begin(char /*introducer*/) -> void {}
+
+        /// @brief Receives a byte of a string.
+        constexpr auto string_put(char) -> void {}
+
+        /// @brief Receives the end of a string terminated by BEL; a string terminated by ST ends with @c esc() instead.
+        constexpr auto string_end() -> void {}
+    };
+
+    /// @brief Escape sequence parser.
+    /// @details Follows the DEC VT500 state machine: the transition for every state and byte is looked up in a table built
+    /// at compile time, and text between control characters is passed on in whole runs. OSC, DCS, SOS, PM and APC strings
+    /// are passed on byte by byte, for handlers that keep them. The parser keeps its state between calls, so input may be
+    /// split anywhere.
+    /// @tparam Handler Type with the callbacks of @c ansi::vt_handler .
+    template <typename Handler>
+    class vt_parser
+    {
+    public:
+        /// @brief Creates a parser in the ground state.
+        /// @param[in,out] handler Callback receiver.
+        explicit constexpr vt_parser(Handler& handler) : handler_(&handler) {}
+
+        /// @brief Parses bytes.
+        /// @param[in] bytes Input.
+        constexpr auto feed(const std::string_view bytes) -> void
+        {
+            const char* p = bytes.data();
+            const char* const end = p + bytes.size();
+
+            while (p != end)
+            {
+                if (state_ == ground)
+                {
+                    const char* run = p;
+                    while (p != end && printable(*p))
+                        ++p;
+
+                    if (p != run)
+                        handler_->print({run, static_cast<std::size_t>(p - run)});
+
+                    if (p == end)
+                        break;
+                }
+
+                const auto c = static_cast<unsigned char>(*p++);
+                const std::uint8_t entry = table[state_][c];
+
+                act(static_cast<action>(entry >> 4), static_cast<char>(c));
+                state_ = static_cast<state>(entry & 0xF);
+            }
+        }
+
+        /// @brief Returns to the ground state, dropping a partial sequence.
+        constexpr auto reset() -> void { state_ = ground; }
+
+    private:
+        /// @brief Parser states.
+        enum state : std::uint8_t
+        {
+            ground,
+            escape,
+            escape_intermediate,
+            csi_entry,
+            csi_param,
+            csi_intermediate,
+            csi_ignore,
+            string,
+            state_count
+        };
+
+        /// @brief Transition actions.
+        enum action : std::uint8_t
+        {
+            none,
+            execute,
+            clear,
+            collect,
+            prefix,
+            param,
+            separator,
+            colon,
+            esc_dispatch,
+            csi_dispatch,
+            string_begin,
+            string_put,
+            string_end
+        };
+
+        /// @brief Transition table entries, action in the high nibble and next state in the low one.
+        using row = std::array<std::uint8_t, 256>;
+
+        /// @brief Packs a transition.
+        static constexpr auto to(const action a, const state s) -> std::uint8_t { return static_cast<std::uint8_t>(a << 4 | s); }
+
+        /// @brief Builds the transition table.
+        static constexpr auto build() -> std::array<row, state_count>
+        {
+            std::array<row, state_count> t{};
+
+            const auto range = [](row& r, const int lo, const int hi, const std::uint8_t e)
+            {
+                for (int c = lo; c <= hi; c++)
+                    r[c] = e;
+            };
+
+            for (int s = 0; s < state_count; s++)
+            {
+                const auto self = static_cast<state>(s);
+                row& r = t[s];
+
+                range(r, 0x00, 0xFF, to(self == string ? string_put : none, self));
+
+                if (self != string)
+                {
+                    range(r, 0x00, 0x17, to(execute, self));
+                    range(r, 0x19, 0x19, to(execute, self));
+                    range(r, 0x1C, 0x1F, to(execute, self));
+                }
+
+                range(r, 0x18, 0x18, to(execute, ground));
+                range(r, 0x1A, 0x1A, to(execute, ground));
+                range(r, 0x1B, 0x1B, to(clear, escape));
+            }
+
+            row& e = t[escape];
+            range(e, 0x20, 0x2F, to(collect, escape_intermediate));
+            range(e, 0x30, 0x7E, to(esc_dispatch, ground));
+            range(e, '[', '[', to(clear, csi_entry));
+            for (const char c : {']', 'P', 'X', '^', '_'})
+                range(e, c, c, to(string_begin, string));
+
+            row& ei = t[escape_intermediate];
+            range(ei, 0x20, 0x2F, to(collect, escape_intermediate));
+            range(ei, 0x30, 0x7E, to(esc_dispatch, ground));
+
+            row& ce = t[csi_entry];
+            range(ce, 0x20, 0x2F, to(collect, csi_intermediate));
+            range(ce, 0x30, 0x39, to(param, csi_param));
+            range(ce, 0x3A, 0x3A, to(colon, csi_param));
+            range(ce, 0x3B, 0x3B, to(separator, csi_param));
+            range(ce, 0x3C, 0x3F, to(prefix, csi_param));
+            range(ce, 0x40, 0x7E, to(csi_dispatch, ground));
+
+            row& cp = t[csi_param];
+            range(cp, 0x20, 0x2F, to(collect, csi_intermediate));
+            range(cp, 0x30, 0x39, to(param, csi_param));
+            range(cp, 0x3A, 0x3A, to(colon, csi_param));
+            range(cp, 0x3B, 0x3B, to(separator, csi_param));
+            range(cp, 0x3C, 0x3F, to(none, csi_ignore));
+            range(cp, 0x40, 0x7E, to(csi_dispatch, ground));
+
+            row& ci = t[csi_intermediate];
+            range(ci, 0x20, 0x2F, to(collect, csi_intermediate));
+            range(ci, 0x30, 0x3F, to(none, csi_ignore));
+            range(ci, 0x40, 0x7E, to(csi_dispatch, ground));
+
+            range(t[csi_ignore], 0x40, 0x7E, to(none, ground));
+
+            range(t[string], 0x07, 0x07, to(string_end, ground));
+
+            return t;
+        }
+
+        /// @brief Transition table.
+        static constexpr std::array<row, state_count> table = build();
+
+        /// @brief Tells whether a byte in the ground state is text.
+        static constexpr auto printable(const char c) -> bool
+        {
+            const auto u = static_cast<unsigned char>(c);
+            return u >= 0x20 && u != 0x7F;
+        }
+
+        /// @brief Performs a transition action.
+        constexpr auto act(const action a, const char c) -> void
+        {
+            switch (a)
+            {
+            case none:
+                break;
+
+            case execute:
+                handler_->execute(c);
+                break;
+
+            case clear:
+                params_.count = 0;
+                params_.colons = 0;
+                params_.prefix = 0;
+                params_.intermediate = 0;
+                current_ = 0;
+                started_ = false;
+                break;
+
+            case collect:
+                params_.intermediate = c;
+                break;
+
+            case prefix:
+                params_.prefix = c;
+                break;
+
+            case param:
+                current_ = current_ * 10 + static_cast<unsigned>(c - '0');
+                if (current_ > 0xFFFF)
+                    current_ = 0xFFFF;
+                started_ = true;
+                break;
+
+            case separator:
+                push();
+                started_ = true;
+                break;
+
+            case colon:
+                if (params_.count < vt_params::max)
+                    params_.colons |= static_cast<std::uint16_t>(1 << params_.count);
+                push();
+                started_ = true;
+                break;
+
+            case esc_dispatch:
+                handler_->esc(params_.intermediate, c);
+                break;
+
+            case csi_dispatch:
+                if (started_)
+                    push();
+                handler_->csi(params_, c);
+                break;
+
+            case string_begin:
+                handler_->string_begin(c);
+                break;
+
+            case string_put:
+                handler_->string_put(c);
+                break;
+
+            case string_end:
+                handler_->string_end();
+                break;
+            }
+        }
+
+        /// @brief Ends the current parameter.
+        constexpr auto push() -> void
+        {
+            if (params_.count < vt_params::max)
+                params_.value[params_.count++] = static_cast<std::uint16_t>(current_);
+
+            current_ = 0;
+        }
+
+        /// @brief Callback receiver.
+        Handler* handler_;
+
+        /// @brief Current state.
+        state state_ = ground;
+
+        /// @brief Parameters collected so far.
+        vt_params params_{};
+
+        /// @brief Value of the parameter being read.
+        unsigned current_ = 0;
+
+        /// @brief Whether a parameter is being read.
+        bool started_ = false;
+    };
+}
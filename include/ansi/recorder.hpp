@@ -0,0 +1,388 @@
+/// @file recorder.hpp
+/// @author Danylo Marchenko (cdanymar)
+/// @brief Defines a session recorder capturing everything written to an output stream for later replay as asciicast v2.
+/// @version 1.0
+/// @date 2024-08-11
+/// @copyright Copyright (c) 2024
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+/// @brief ANSI Escape Codes.
+namespace ansi
+{
+    /// @brief Session recorder.
+    /// @details Attaches to an output stream and forwards everything written to it, copying the bytes into a ring buffer on
+    /// the way. Bytes are recorded once per flush of the internal put area, together with a millisecond timestamp, so the
+    /// per-character cost is a plain buffer append. The ring is written by a single producer and may be dumped concurrently
+    /// from any thread; bytes and timestamps overwritten during a dump are dropped from it.
+    ///
+    /// The put area of 4 KiB sits in front of the stream's own buffer, so output reaches it only when the put area fills
+    /// or the stream is flushed. Output to @c std::cout that is otherwise passed on at once, as when it is synchronized
+    /// with stdio, is then held back, and interleaves differently with @c printf and other writes to the same file.
+    /// Flush the stream where the order matters.
+    /// @warning Like the stream it is attached to, the recorder itself is not safe to write from several threads at once.
+    class recorder final : public std::streambuf
+    {
+    public:
+        /// @brief Attaches a recorder to an output stream.
+        /// @param[in,out] target   Output stream, e.g. @c std::cout used by @c ansi::print .
+        /// @param[in]     capacity Ring capacity in bytes, rounded up to a power of two.
+        /// @param[in]     events   Timestamp ring capacity, rounded up to a power of two.
+        explicit recorder(std::ostream& target, const std::size_t capacity = 1 << 20, const std::size_t events = 1 << 14)
+            : target_(&target), sink_(target.rdbuf()),
+              bytes_(std::make_unique<char[]>(std::bit_ceil(capacity))), byte_mask_(std::bit_ceil(capacity) - 1),
+              events_(std::make_unique<event[]>(std::bit_ceil(events))), event_mask_(std::bit_ceil(events) - 1),
+              start_(clock::now()), unix_start_(std::time(nullptr))
+        {
+            setp(local_, local_ + sizeof local_);
+            target.rdbuf(this);
+        }
+
+        recorder(const recorder&) = delete;
+        auto operator=(const recorder&) -> recorder& = delete;
+
+        /// @brief Flushes pending bytes and gives the stream its original buffer back.
+        ~recorder() override
+        {
+            if (crash_recorder_.load() == this)
+                crash_recorder_.store(nullptr);
+
+            detach();
+        }
+
+        /// @brief Flushes pending bytes and gives the stream its original buffer back.
+        /// @details The recorded session stays available for @c dump() .
+        auto detach() -> void
+        {
+            if (!target_)
+                return;
+
+            sync();
+            target_->rdbuf(sink_);
+            target_ = nullptr;
+        }
+
+        /// @brief Writes the recorded session as asciicast v2.
+        /// @details Only the most recent bytes that are still in the ring are written.
+        /// @param[out] os     Output stream.
+        /// @param[in]  width  Terminal width put into the header.
+        /// @param[in]  height Terminal height put into the header.
+        auto dump(std::ostream& os, const unsigned width = 80, const unsigned height = 24) const -> void
+        {
+            os << "{\"version\": 2, \"width\": " << width << ", \"height\": " << height
+               << ", \"timestamp\": " << static_cast<long long>(unix_start_) << "}\n";
+
+            const std::uint64_t event_count = event_count_.load(std::memory_order_acquire);
+            const std::uint64_t byte_count = byte_count_.load(std::memory_order_acquire);
+            const std::uint64_t event_first = event_count > event_mask_ + 1 ? event_count - event_mask_ - 1 : 0;
+            const std::uint64_t byte_first = byte_count > byte_mask_ + 1 ? byte_count - byte_mask_ - 1 : 0;
+
+            std::string pending;
+
+            for (std::uint64_t i = event_first; i < event_count; i++)
+            {
+                const event& e = events_[i & event_mask_];
+                const std::uint64_t end = i + 1 < event_count ? events_[(i + 1) & event_mask_].begin.load(std::memory_order_relaxed) : byte_count;
+                const std::uint64_t begin = std::max(e.begin.load(std::memory_order_relaxed), byte_first);
+                const std::int64_t ms = e.ms.load(std::memory_order_relaxed);
+
+                // Skip the event if the producer started overwriting it while it was being read; its bytes are older
+                // still and gone too.
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (event_claimed_.load(std::memory_order_relaxed) > i + event_mask_ + 1)
+                    continue;
+
+                if (begin >= end)
+                    continue;
+
+                const std::size_t kept = pending.size();
+                pending.resize(kept + (end - begin));
+                copy_out(pending.data() + kept, begin, end - begin);
+
+                // Drop what the producer overwrote while it was being copied.
+                std::atomic_thread_fence(std::memory_order_acquire);
+                const std::uint64_t now = byte_claimed_.load(std::memory_order_relaxed);
+                if (now > byte_mask_ + 1 && now - byte_mask_ - 1 > begin)
+                {
+                    const std::uint64_t lost = std::min(now - byte_mask_ - 1 - begin, end - begin);
+                    pending.erase(kept, lost);
+                }
+
+                // Skip continuation bytes of a code point whose start fell out of the ring.
+                if (kept == 0)
+                    pending.erase(0, std::min(pending.find_first_not_of(continuation_bytes()), pending.size()));
+
+                const std::size_t complete = utf8_complete(pending);
+                if (complete == 0)
+                    continue;
+
+                const char millis[] = {static_cast<char>('0' + ms / 100 % 10), static_cast<char>('0' + ms / 10 % 10), static_cast<char>('0' + ms % 10)};
+                os << '[' << ms / 1000 << '.';
+                os.write(millis, sizeof millis) << ", \"o\", \"";
+                escape(os, pending.data(), complete);
+                os << "\"]\n";
+
+                pending.erase(0, complete);
+            }
+        }
+
+        /// @brief Dumps this recorder to a file when the process crashes.
+        /// @details Installs handlers for @c SIGSEGV, @c SIGABRT, @c SIGFPE and @c SIGILL that write the session as asciicast
+        /// v2 and then re-raise the signal with the default action. Only one recorder can be registered at a time.
+        /// @warning Best effort; writing a file is not async-signal-safe.
+        /// @param[in] path Destination file path, must outlive the recorder.
+        auto dump_on_crash(const char* path) -> void
+        {
+            crash_path_ = path;
+            crash_recorder_.store(this);
+
+            for (const int sig : {SIGSEGV, SIGABRT, SIGFPE, SIGILL})
+                std::signal(sig, &recorder::on_crash);
+        }
+
+    protected:
+        /// @brief Records and forwards the put area, then stores the character.
+        auto overflow(const int_type ch) -> int_type override
+        {
+            if (flush_local() == -1)
+                return traits_type::eof();
+
+            if (traits_type::eq_int_type(ch, traits_type::eof()))
+                return traits_type::not_eof(ch);
+
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+            return ch;
+        }
+
+        /// @brief Appends to the put area, or records and forwards large blocks directly.
+        auto xsputn(const char* s, const std::streamsize n) -> std::streamsize override
+        {
+            if (n > epptr() - pptr())
+            {
+                if (flush_local() == -1)
+                    return 0;
+
+                if (n >= epptr() - pptr())
+                {
+                    record(s, static_cast<std::size_t>(n));
+                    return sink_->sputn(s, n);
+                }
+            }
+
+            std::memcpy(pptr(), s, static_cast<std::size_t>(n));
+            pbump(static_cast<int>(n));
+            return n;
+        }
+
+        /// @brief Records and forwards the put area, then flushes the original buffer.
+        auto sync() -> int override
+        {
+            if (flush_local() == -1)
+                return -1;
+
+            return sink_->pubsync();
+        }
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        /// @brief Timestamp of the bytes starting at @c begin .
+        struct event
+        {
+            /// @brief Position of the first byte in the whole session.
+            std::atomic<std::uint64_t> begin;
+
+            /// @brief Milliseconds since the recorder was attached.
+            std::atomic<std::int64_t> ms;
+        };
+
+        /// @brief Records the put area and forwards it to the original buffer.
+        auto flush_local() -> int
+        {
+            const std::ptrdiff_t n = pptr() - pbase();
+            if (n == 0)
+                return 0;
+
+            record(pbase(), static_cast<std::size_t>(n));
+            setp(local_, local_ + sizeof local_);
+
+            return sink_->sputn(local_, n) == n ? 0 : -1;
+        }
+
+        /// @brief Copies bytes into the ring, opening a new event if the clock moved.
+        auto record(const char* s, std::size_t n) -> void
+        {
+            const std::int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start_).count();
+            const std::uint64_t pos = byte_count_.load(std::memory_order_relaxed);
+            const std::uint64_t events = event_count_.load(std::memory_order_relaxed);
+
+            // Positions are claimed before the ring is written and published after, so that a concurrent dump can tell
+            // which of the entries it read may have been overwritten.
+            if (events == 0 || events_[(events - 1) & event_mask_].ms.load(std::memory_order_relaxed) != ms)
+            {
+                event_claimed_.store(events + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                events_[events & event_mask_].begin.store(pos, std::memory_order_relaxed);
+                events_[events & event_mask_].ms.store(ms, std::memory_order_relaxed);
+                event_count_.store(events + 1, std::memory_order_release);
+            }
+
+            // Only the tail of a block larger than the ring survives.
+            const std::size_t capacity = byte_mask_ + 1;
+            std::uint64_t at = pos;
+            if (n > capacity)
+            {
+                at += n - capacity;
+                s += n - capacity;
+                n = capacity;
+            }
+
+            byte_claimed_.store(at + n, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            const std::size_t offset = at & byte_mask_;
+            const std::size_t first = std::min(n, capacity - offset);
+            std::memcpy(bytes_.get() + offset, s, first);
+            std::memcpy(bytes_.get(), s + first, n - first);
+
+            byte_count_.store(at + n, std::memory_order_release);
+        }
+
+        /// @brief Copies bytes out of the ring.
+        auto copy_out(char* dst, const std::uint64_t begin, const std::size_t n) const -> void
+        {
+            const std::size_t offset = begin & byte_mask_;
+            const std::size_t first = std::min(n, byte_mask_ + 1 - offset);
+            std::memcpy(dst, bytes_.get() + offset, first);
+            std::memcpy(dst + first, bytes_.get(), n - first);
+        }
+
+        /// @brief Length of the prefix that does not end inside a UTF-8 code point.
+        static auto utf8_complete(const std::string& s) -> std::size_t
+        {
+            std::size_t i = s.size();
+            std::size_t back = 0;
+
+            while (i > 0 && back < 4 && (static_cast<unsigned char>(s[i - 1]) & 0xC0) == 0x80)
+                i--, back++;
+
+            if (i == 0)
+                return s.size();
+
+            const auto lead = static_cast<unsigned char>(s[i - 1]);
+            const std::size_t need = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+
+            return need > back + 1 ? i - 1 : s.size();
+        }
+
+        /// @brief All UTF-8 continuation bytes.
+        static auto continuation_bytes() -> const std::string&
+        {
+            static const std::string bytes = []
+            {
+                std::string s;
+                for (int c = 0x80; c < 0xC0; c++)
+                    s += static_cast<char>(c);
+                return s;
+            }();
+
+            return bytes;
+        }
+
+        /// @brief Writes bytes as the contents of a JSON string.
+        static auto escape(std::ostream& os, const char* s, const std::size_t n) -> void
+        {
+            static constexpr char hex[] = "0123456789abcdef";
+
+            for (std::size_t i = 0; i < n; i++)
+            {
+                const auto c = static_cast<unsigned char>(s[i]);
+
+                if (c == '"' || c == '\\')
+                    os << '\\' << static_cast<char>(c);
+                else if (c == '\n')
+                    os << "\\n";
+                else if (c == '\r')
+                    os << "\\r";
+                else if (c == '\t')
+                    os << "\\t";
+                else if (c < 0x20 || c == 0x7F)
+                    os << "\\u00" << hex[c >> 4] << hex[c & 0xF];
+                else
+                    os << static_cast<char>(c);
+            }
+        }
+
+        /// @brief Signal handler installed by @c dump_on_crash() .
+        static auto on_crash(const int sig) -> void
+        {
+            if (const recorder* self = crash_recorder_.exchange(nullptr))
+            {
+                std::ofstream file(self->crash_path_, std::ios::binary);
+                self->dump(file);
+            }
+
+            std::signal(sig, SIG_DFL);
+            std::raise(sig);
+        }
+
+        /// @brief Recorded stream, null once detached.
+        std::ostream* target_;
+
+        /// @brief Original stream buffer.
+        std::streambuf* sink_;
+
+        /// @brief Byte ring.
+        std::unique_ptr<char[]> bytes_;
+
+        /// @brief Byte ring capacity minus one.
+        std::size_t byte_mask_;
+
+        /// @brief Timestamp ring.
+        std::unique_ptr<event[]> events_;
+
+        /// @brief Timestamp ring capacity minus one.
+        std::size_t event_mask_;
+
+        /// @brief Number of bytes ever recorded.
+        std::atomic<std::uint64_t> byte_count_{0};
+
+        /// @brief Number of events ever recorded.
+        std::atomic<std::uint64_t> event_count_{0};
+
+        /// @brief Number of bytes ever recorded, including those being copied into the ring.
+        std::atomic<std::uint64_t> byte_claimed_{0};
+
+        /// @brief Number of events ever recorded, including the one being written.
+        std::atomic<std::uint64_t> event_claimed_{0};
+
+        /// @brief Attach time.
+        clock::time_point start_;
+
+        /// @brief Attach time for the asciicast header.
+        std::time_t unix_start_;
+
+        /// @brief Put area.
+        char local_[4096];
+
+        /// @brief Path used by @c on_crash() .
+        const char* crash_path_ = nullptr;
+
+        /// @brief Recorder registered with @c dump_on_crash() .
+        static inline std::atomic<const recorder*> crash_recorder_{nullptr};
+    };
+}
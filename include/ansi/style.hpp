@@ -0,0 +1,395 @@
+/// @file style.hpp
+/// @author Danylo Marchenko (cdanymar)
+/// @brief Defines the graphic rendition state selected by SGR sequences.
+/// @version 1.0
+/// @date 2024-08-11
+/// @copyright Copyright (c) 2024
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "csi.hpp"
+#include "parser.hpp"
+
+/// @brief ANSI Escape Codes.
+namespace ansi
+{
+    /// @brief Color of a character layer.
+    /// @details Basic and bright colors are stored as the first 16 entries of the 8-bit palette, as terminals treat them.
+    struct color
+    {
+        /// @brief Color kinds, numbered after the SGR sub-parameter selecting them.
+        enum kind_t : byte
+        {
+            none = 0, ///< Default color.
+            direct = 2, ///< RGB 24-bit color.
+            indexed = 5 ///< 8-bit color.
+        };
+
+        /// @brief Color kind.
+        kind_t kind = none;
+
+        /// @brief Palette index, or red channel.
+        byte r = 0;
+
+        /// @brief Green channel.
+        byte g = 0;
+
+        /// @brief Blue channel.
+        byte b = 0;
+
+        /// @brief Compares two colors.
+        constexpr auto operator==(const color&) const -> bool = default;
+    };
+
+    /// @brief Graphic rendition of a character.
+    struct style
+    {
+        /// @brief Attribute flags.
+        enum attribute : std::uint16_t
+        {
+            bold = 1 << 0, ///< Bold or increased intensity.
+            faint = 1 << 1, ///< Faint or decreased intensity.
+            italic = 1 << 2, ///< Italic.
+            underline = 1 << 3, ///< Underlined.
+            blink = 1 << 4, ///< Slow blink.
+            blink_fast = 1 << 5, ///< Rapid blink.
+            invert = 1 << 6, ///< Swapped foreground and background.
+            conceal = 1 << 7, ///< Hidden.
+            strike = 1 << 8, ///< Crossed out.
+            double_underline = 1 << 9, ///< Doubly underlined.
+            overline = 1 << 10 ///< Overlined.
+        };
+
+        /// @brief Set of @c attribute flags.
+        std::uint16_t attrs = 0;
+
+        /// @brief Foreground color.
+        color fg;
+
+        /// @brief Background color.
+        color bg;
+
+        /// @brief Underline color.
+        color ul;
+
+        /// @brief Compares two styles.
+        constexpr auto operator==(const style&) const -> bool = default;
+
+        /// @brief Applies the parameters of one SGR sequence.
+        /// @details An empty parameter list resets, as does a missing parameter anywhere in the list.
+        /// @param[in] params Parameter values.
+        /// @param[in] count  Number of parameters.
+        constexpr auto apply(const std::uint16_t* params, const std::size_t count) -> void
+        {
+            if (count == 0)
+            {
+                *this = {};
+                return;
+            }
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                const std::uint16_t p = params[i];
+
+                switch (p)
+                {
+                case 0: *this = {}; break;
+                case 1: attrs |= bold; break;
+                case 2: attrs |= faint; break;
+                case 3: attrs |= italic; break;
+                case 4: attrs |= underline; break;
+                case 5: attrs |= blink; break;
+                case 6: attrs |= blink_fast; break;
+                case 7: attrs |= invert; break;
+                case 8: attrs |= conceal; break;
+                case 9: attrs |= strike; break;
+                case 21: attrs |= double_underline; break;
+                case 22: attrs &= ~(bold | faint); break;
+                case 23: attrs &= ~italic; break;
+                case 24: attrs &= ~(underline | double_underline); break;
+                case 25: attrs &= ~(blink | blink_fast); break;
+                case 27: attrs &= ~invert; break;
+                case 28: attrs &= ~conceal; break;
+                case 29: attrs &= ~strike; break;
+                case 39: fg = {}; break;
+                case 49: bg = {}; break;
+                case 53: attrs |= overline; break;
+                case 55: attrs &= ~overline; break;
+                case 59: ul = {}; break;
+
+                case 38:
+                case 48:
+                case 58:
+                {
+                    color c;
+                    i += extended(params + i + 1, count - i - 1, c);
+                    (p == 38 ? fg : p == 48 ? bg : ul) = c;
+                    break;
+                }
+
+                default:
+                    if (p >= 30 && p <= 37)
+                        fg = {color::indexed, static_cast<byte>(p - 30)};
+                    else if (p >= 40 && p <= 47)
+                        bg = {color::indexed, static_cast<byte>(p - 40)};
+                    else if (p >= 90 && p <= 97)
+                        fg = {color::indexed, static_cast<byte>(p - 90 + 8)};
+                    else if (p >= 100 && p <= 107)
+                        bg = {color::indexed, static_cast<byte>(p - 100 + 8)};
+                    break;
+                }
+            }
+        }
+
+        /// @brief Applies a single-valued CSI.
+        /// @param[in] obj SGR such as the constants in @c ansi::manipulators .
+        constexpr auto apply(const sgr& obj) -> void
+        {
+            const std::uint16_t p = obj.value[0];
+            apply(&p, 1);
+        }
+
+        /// @brief Applies a multi-valued CSI.
+        /// @param[in] obj SGR such as the results of @c fg::set() or @c fg::rgb() .
+        template <std::size_t N>
+        constexpr auto apply(const csi<N>& obj) -> void
+        {
+            std::uint16_t p[N];
+            for (std::size_t i = 0; i < N; i++)
+                p[i] = obj.value[i];
+
+            apply(p, N);
+        }
+
+        /// @brief Upper bound of the length of a rendered style.
+        static constexpr std::size_t max_length = 96;
+
+        /// @brief Renders a single SGR selecting the style from any previous one.
+        /// @details Starts with a reset, followed by the attributes and colors that differ from the default.
+        /// @param[out] out Destination of at least @c max_length bytes.
+        /// @return Number of bytes written.
+        constexpr auto render(char* const out) const -> std::size_t
+        {
+            std::size_t size = 0;
+            out[size++] = '\x1b';
+            out[size++] = '[';
+            out[size++] = '0';
+
+            for (const auto& [flag, code, off] : codes)
+                if (attrs & flag)
+                    put(out, size, code);
+
+            put(out, size, fg, {}, 30, 90, 38);
+            put(out, size, bg, {}, 40, 100, 48);
+            put(out, size, ul, {}, 0, 0, 58);
+
+            out[size++] = 'm';
+            return size;
+        }
+
+        /// @brief Renders the shortest single SGR changing another style into this one.
+        /// @details Chooses between turning off and on only the attributes and colors that differ, and a full reset.
+        /// @param[out] out  Destination of at least @c max_length bytes.
+        /// @param[in]  from Style in effect before.
+        /// @return Number of bytes written, zero if the styles are equal.
+        constexpr auto render(char* const out, const style& from) const -> std::size_t
+        {
+            if (*this == from)
+                return 0;
+
+            if (*this == style{})
+            {
+                out[0] = '\x1b';
+                out[1] = '[';
+                out[2] = 'm';
+                return 3;
+            }
+
+            // Parameters are written with a separator before them, the one of the first is replaced by the bracket.
+            char diff[2 * max_length];
+            std::size_t size = 1;
+
+            std::uint16_t removed = from.attrs & ~attrs;
+            std::uint16_t added = attrs & ~from.attrs;
+
+            // An attribute turned off by a code shared with another one is turned on again if still set.
+            for (const auto& [flag, code, off] : codes)
+                if (removed & flag)
+                {
+                    put(diff, size, off);
+                    for (const auto& other : codes)
+                        if (other.off == off)
+                        {
+                            removed &= ~other.flag;
+                            added |= attrs & other.flag;
+                        }
+                }
+
+            for (const auto& [flag, code, off] : codes)
+                if (added & flag)
+                    put(diff, size, code);
+
+            put(diff, size, fg, from.fg, 30, 90, 38);
+            put(diff, size, bg, from.bg, 40, 100, 48);
+            put(diff, size, ul, from.ul, 0, 0, 58);
+
+            diff[0] = '\x1b';
+            diff[1] = '[';
+            diff[size++] = 'm';
+
+            // The full reset is at least "\x1b[0m" and two bytes per attribute and three per color, so it is only
+            // rendered when it may be shorter.
+            std::size_t least = 4 + 3 * ((fg != color{}) + (bg != color{}) + (ul != color{}));
+            for (std::uint16_t a = attrs; a != 0; a &= a - 1)
+                least += 2;
+
+            if (size >= least)
+            {
+                const std::size_t full = render(out);
+                if (size >= full)
+                    return full;
+            }
+
+            for (std::size_t i = 0; i < size; i++)
+                out[i] = diff[i];
+
+            return size;
+        }
+
+    private:
+        /// @brief SGR codes turning each attribute on and off.
+        static constexpr struct
+        {
+            attribute flag;
+            byte code;
+            byte off;
+        } codes[] = {
+            {bold, 1, 22}, {faint, 2, 22}, {italic, 3, 23}, {underline, 4, 24}, {blink, 5, 25}, {blink_fast, 6, 25},
+            {invert, 7, 27}, {conceal, 8, 28}, {strike, 9, 29}, {double_underline, 21, 24}, {overline, 53, 55}
+        };
+
+        /// @brief Appends a separator and a parameter.
+        static constexpr auto put(char* const out, std::size_t& size, const unsigned n) -> void
+        {
+            out[size++] = ';';
+            size += ansi::render(static_cast<byte>(n), out + size);
+        }
+
+        /// @brief Appends the parameters selecting a color, if it differs from the previous one.
+        /// @param[out]    out    Destination.
+        /// @param[in,out] size   Bytes written so far.
+        /// @param[in]     c      Color.
+        /// @param[in]     from   Previous color.
+        /// @param[in]     base   Code of the first basic color, zero if the layer has none.
+        /// @param[in]     bright Code of the first bright color, zero if the layer has none.
+        /// @param[in]     layer  Extended color selector; 1 more turns the color off.
+        static constexpr auto put(char* const out, std::size_t& size, const color& c, const color& from,
+            const unsigned base, const unsigned bright, const unsigned layer) -> void
+        {
+            if (c == from)
+                return;
+
+            if (c.kind == color::none)
+                put(out, size, layer + 1);
+            else if (c.kind == color::indexed && c.r < 8 && base != 0)
+                put(out, size, base + c.r);
+            else if (c.kind == color::indexed && c.r < 16 && bright != 0)
+                put(out, size, bright + c.r - 8);
+            else if (c.kind == color::indexed)
+            {
+                put(out, size, layer);
+                put(out, size, color::indexed);
+                put(out, size, c.r);
+            }
+            else
+            {
+                put(out, size, layer);
+                put(out, size, color::direct);
+                put(out, size, c.r);
+                put(out, size, c.g);
+                put(out, size, c.b);
+            }
+        }
+
+        /// @brief Reads the sub-parameters of an extended color.
+        /// @param[in]  params Parameters following 38, 48 or 58.
+        /// @param[in]  count  Number of parameters left.
+        /// @param[out] c      Color read, default if malformed.
+        /// @return Number of parameters consumed.
+        static constexpr auto extended(const std::uint16_t* params, const std::size_t count, color& c) -> std::size_t
+        {
+            if (count >= 2 && params[0] == color::indexed)
+            {
+                c = {color::indexed, static_cast<byte>(params[1])};
+                return 2;
+            }
+
+            if (count >= 4 && params[0] == color::direct)
+            {
+                c = {color::direct, static_cast<byte>(params[1]), static_cast<byte>(params[2]), static_cast<byte>(params[3])};
+                return 4;
+            }
+
+            return count;
+        }
+    };
+
+    /// @brief Effect of a run of SGR sequences on a style, independent of the style before it.
+    /// @details Every SGR sets or clears attributes and colors without reading them, so the effect of a run is known
+    /// from two probes: one starting with all attributes off and colors marked untouched, one with all attributes on.
+    /// Effects of consecutive runs, computed in parallel, are then chained by applying them in order.
+    struct sgr_effect
+    {
+        /// @brief Color kind marking a color the run did not touch.
+        static constexpr auto untouched = static_cast<color::kind_t>(0xFF);
+
+        /// @brief Result of the run applied to a style with all attributes off and untouched colors.
+        style from_off{0, {untouched}, {untouched}, {untouched}};
+
+        /// @brief Result of the run applied to a style with all attributes on.
+        style from_on{0xFFFF, {}, {}, {}};
+
+        /// @brief Extends the run by one SGR sequence.
+        /// @param[in] params Parameter values.
+        /// @param[in] count  Number of parameters.
+        constexpr auto apply(const std::uint16_t* params, const std::size_t count) -> void
+        {
+            from_off.apply(params, count);
+            from_on.apply(params, count);
+        }
+
+        /// @brief Applies the effect to a style.
+        /// @param[in] before Style in effect before the run.
+        /// @return Style in effect after the run.
+        constexpr auto apply(const style& before) const -> style
+        {
+            style after = before;
+            after.attrs = static_cast<std::uint16_t>((before.attrs & from_on.attrs) | from_off.attrs);
+
+            if (from_off.fg.kind != untouched)
+                after.fg = from_off.fg;
+            if (from_off.bg.kind != untouched)
+                after.bg = from_off.bg;
+            if (from_off.ul.kind != untouched)
+                after.ul = from_off.ul;
+
+            return after;
+        }
+    };
+
+    /// @brief Parser callbacks reducing a run of input to its effect on the style.
+    struct sgr_collector : vt_handler
+    {
+        /// @brief Effect so far.
+        sgr_effect effect;
+
+        /// @brief Applies an SGR.
+        auto csi(const vt_params& p, const char final) -> void
+        {
+            if (final == 'm' && p.prefix == 0 && p.intermediate == 0)
+                effect.apply(p.value, p.count);
+        }
+    };
+}
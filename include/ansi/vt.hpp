@@ -0,0 +1,564 @@
+/// @file vt.hpp
+/// @author Danylo Marchenko (cdanymar)
+/// @brief Defines a headless terminal screen that interprets the sequences of this library into a grid of cells.
+/// @version 1.0
+/// @date 2024-08-11
+/// @copyright Copyright (c) 2024
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "csi.hpp"
+#include "parser.hpp"
+#include "style.hpp"
+
+/// @brief ANSI Escape Codes.
+namespace ansi
+{
+    /// @brief Headless terminal screen.
+    /// @details Interprets caret, line, erase and scroll movements, SGR styles and colors, and the C0 controls, into an
+    /// in-memory grid. Erased cells take the current background. Sequences it does not model are parsed and ignored.
+    class vt
+    {
+    public:
+        /// @brief Screen cell.
+        struct cell
+        {
+            /// @brief Code point.
+            char32_t ch = U' ';
+
+            /// @brief Graphic rendition.
+            style attr;
+
+            /// @brief Compares two cells.
+            constexpr auto operator==(const cell&) const -> bool = default;
+        };
+
+        /// @brief Creates a blank screen with the caret at the origin.
+        /// @param[in] rows    Number of rows.
+        /// @param[in] columns Number of columns.
+        /// @param[in] newline Whether line feed also returns the caret, as a terminal behind a tty translating newlines.
+        explicit vt(const std::size_t rows = 24, const std::size_t columns = 80, const bool newline = true)
+            : rows_(std::max<std::size_t>(rows, 1)), columns_(std::max<std::size_t>(columns, 1)), newline_(newline),
+              cells_(rows_ * columns_), parser_(*this)
+        {
+        }
+
+        vt(const vt&) = delete;
+        auto operator=(const vt&) -> vt& = delete;
+
+        /// @brief Interprets bytes.
+        /// @param[in] bytes Output as sent to a terminal, may be split anywhere.
+        auto write(const std::string_view bytes) -> void
+        {
+            bytes_ += bytes.size();
+            parser_.feed(bytes);
+        }
+
+        /// @brief Clears the screen and all terminal state, as a full reset (RIS) does.
+        /// @details The @c bytes() and @c sequences() counters describe the stream rather than the terminal and are kept.
+        auto reset() -> void
+        {
+            std::fill(cells_.begin(), cells_.end(), cell{});
+            top_ = 0;
+            row_ = column_ = saved_row_ = saved_column_ = 0;
+            wrap_ = false;
+            pen_ = saved_pen_ = {};
+            need_ = 0;
+            parser_.reset();
+        }
+
+        /// @brief Reads a cell.
+        /// @param[in] row    Row index, 0-based.
+        /// @param[in] column Column index, 0-based.
+        /// @return Cell reference.
+        auto at(const std::size_t row, const std::size_t column) const -> const cell&
+        {
+            return line_data(row)[column];
+        }
+
+        /// @brief Reads the text of a row.
+        /// @param[in] row Row index, 0-based.
+        /// @return UTF-8 text with trailing blanks removed.
+        auto line(const std::size_t row) const -> std::string
+        {
+            std::string text;
+            std::size_t kept = 0;
+
+            for (std::size_t c = 0; c < columns_; c++)
+            {
+                encode(text, at(row, c).ch);
+                if (at(row, c).ch != U' ')
+                    kept = text.size();
+            }
+
+            text.resize(kept);
+            return text;
+        }
+
+        /// @brief Reads the text of the screen.
+        /// @return Rows as by @c line(), each ended with a newline.
+        auto text() const -> std::string
+        {
+            std::string text;
+            for (std::size_t r = 0; r < rows_; r++)
+                text.append(line(r)) += '\n';
+
+            return text;
+        }
+
+        /// @brief Number of rows.
+        auto rows() const -> std::size_t { return rows_; }
+
+        /// @brief Number of columns.
+        auto columns() const -> std::size_t { return columns_; }
+
+        /// @brief Caret row, 0-based.
+        auto caret_row() const -> std::size_t { return row_; }
+
+        /// @brief Caret column, 0-based.
+        auto caret_column() const -> std::size_t { return column_; }
+
+        /// @brief Style applied to the following characters.
+        auto pen() const -> const style& { return pen_; }
+
+        /// @brief Number of bytes written so far.
+        auto bytes() const -> std::uint64_t { return bytes_; }
+
+        /// @brief Number of escape sequences interpreted or ignored so far.
+        auto sequences() const -> std::uint64_t { return sequences_; }
+
+    private:
+        friend class vt_parser<vt>;
+
+        /// @brief Puts a run of text at the caret.
+        auto print(const std::string_view bytes) -> void
+        {
+            const char* p = bytes.data();
+            const char* const end = p + bytes.size();
+
+            while (p != end)
+            {
+                const auto u = static_cast<unsigned char>(*p);
+
+                if (u < 0x80)
+                {
+                    if (need_ != 0)
+                        put(U'\uFFFD');
+
+                    need_ = 0;
+
+                    const char* run = p;
+                    while (p != end && static_cast<unsigned char>(*p) < 0x80)
+                        ++p;
+
+                    put_ascii(run, p);
+                    continue;
+                }
+
+                ++p;
+
+                if (u < 0xC0)
+                {
+                    if (need_ == 0)
+                    {
+                        put(U'\uFFFD');
+                        continue;
+                    }
+
+                    code_ = code_ << 6 | (u & 0x3F);
+                    if (--need_ == 0)
+                        put(code_);
+                }
+                else
+                {
+                    if (need_ != 0)
+                        put(U'\uFFFD');
+
+                    need_ = u >= 0xF0 ? 3 : u >= 0xE0 ? 2 : 1;
+                    code_ = u & (0x3F >> need_);
+                }
+            }
+        }
+
+        /// @brief Performs a C0 control character.
+        auto execute(const char c) -> void
+        {
+            need_ = 0;
+
+            switch (c)
+            {
+            case '\b':
+                wrap_ = false;
+                if (column_ > 0)
+                    column_--;
+                break;
+
+            case '\t':
+                wrap_ = false;
+                column_ = std::min((column_ / 8 + 1) * 8, columns_ - 1);
+                break;
+
+            case '\n':
+            case '\v':
+            case '\f':
+                if (newline_)
+                    column_ = 0;
+                index();
+                break;
+
+            case '\r':
+                wrap_ = false;
+                column_ = 0;
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        /// @brief Performs an escape sequence other than a CSI.
+        auto esc(const char intermediate, const char final) -> void
+        {
+            need_ = 0;
+            sequences_++;
+
+            if (intermediate != 0)
+                return;
+
+            switch (final)
+            {
+            case '7': save(); break;
+            case '8': restore(); break;
+            case 'D': index(); break;
+            case 'E': column_ = 0; index(); break;
+            case 'M': reverse_index(); break;
+            case 'c': reset(); break;
+            default: break;
+            }
+        }
+
+        /// @brief Ignores the start of an OSC, DCS, SOS, PM or APC string.
+        auto string_begin(char) -> void {}
+
+        /// @brief Ignores string bytes.
+        auto string_put(char) -> void {}
+
+        /// @brief Ignores the end of a string.
+        auto string_end() -> void {}
+
+        /// @brief Performs a CSI.
+        auto csi(const vt_params& p, const char final) -> void
+        {
+            need_ = 0;
+            sequences_++;
+
+            // Soft reset: the default rendition, also saved with the caret at the origin.
+            if (p.prefix == 0 && p.intermediate == '!' && final == 'p')
+            {
+                pen_ = saved_pen_ = {};
+                saved_row_ = saved_column_ = 0;
+                return;
+            }
+
+            if (p.prefix != 0 || p.intermediate != 0)
+                return;
+
+            const std::size_t n = p.get(0, 1);
+
+            switch (final)
+            {
+            case 'A': wrap_ = false; row_ -= std::min(n, row_); break;
+            case 'B': wrap_ = false; row_ = std::min(row_ + n, rows_ - 1); break;
+            case 'C': wrap_ = false; column_ = std::min(column_ + n, columns_ - 1); break;
+            case 'D': wrap_ = false; column_ -= std::min(n, column_); break;
+            case 'E': wrap_ = false; row_ = std::min(row_ + n, rows_ - 1); column_ = 0; break;
+            case 'F': wrap_ = false; row_ -= std::min(n, row_); column_ = 0; break;
+            case 'G': wrap_ = false; column_ = std::min(n, columns_) - 1; break;
+            case 'd': wrap_ = false; row_ = std::min(n, rows_) - 1; break;
+
+            case 'H':
+            case 'f':
+                wrap_ = false;
+                row_ = std::min<std::size_t>(n, rows_) - 1;
+                column_ = std::min<std::size_t>(p.get(1, 1), columns_) - 1;
+                break;
+
+            case 'J':
+                switch (p.get(0, 0))
+                {
+                case 0: blank(row_, column_, rows_ - 1, columns_); break;
+                case 1: blank(0, 0, row_, column_ + 1); break;
+                default: blank(0, 0, rows_ - 1, columns_); break;
+                }
+                break;
+
+            case 'K':
+                switch (p.get(0, 0))
+                {
+                case 0: blank(row_, column_, row_, columns_); break;
+                case 1: blank(row_, 0, row_, column_ + 1); break;
+                default: blank(row_, 0, row_, columns_); break;
+                }
+                break;
+
+            case 'S': scroll_up(n); break;
+            case 'T': scroll_down(n); break;
+            case 's': save(); break;
+            case 'u': restore(); break;
+            case 'm': pen_.apply(p.value, p.count); break;
+            default: break;
+            }
+        }
+
+        /// @brief Puts a code point at the caret and advances it.
+        auto put(const char32_t ch) -> void
+        {
+            if (wrap_)
+            {
+                wrap_ = false;
+                column_ = 0;
+                index();
+            }
+
+            line_data(row_)[column_] = {ch, pen_};
+
+            if (column_ + 1 < columns_)
+                column_++;
+            else
+                wrap_ = true;
+        }
+
+        /// @brief Finds the cells of a screen row.
+        auto line_data(const std::size_t row) -> cell*
+        {
+            const std::size_t r = top_ + row;
+            return cells_.data() + (r < rows_ ? r : r - rows_) * columns_;
+        }
+
+        /// @brief Finds the cells of a screen row.
+        auto line_data(const std::size_t row) const -> const cell*
+        {
+            const std::size_t r = top_ + row;
+            return cells_.data() + (r < rows_ ? r : r - rows_) * columns_;
+        }
+
+        /// @brief Puts a run of ASCII characters at the caret, a row at a time.
+        auto put_ascii(const char* p, const char* const end) -> void
+        {
+            while (p != end)
+            {
+                if (wrap_)
+                {
+                    wrap_ = false;
+                    column_ = 0;
+                    index();
+                }
+
+                cell* const line = line_data(row_);
+                const std::size_t n = std::min(static_cast<std::size_t>(end - p), columns_ - column_);
+
+                cell c{U' ', pen_};
+                cell* const dst = line + column_;
+                for (std::size_t i = 0; i < n; i++)
+                {
+                    c.ch = static_cast<unsigned char>(p[i]);
+                    dst[i] = c;
+                }
+
+                p += n;
+                column_ += n;
+
+                if (column_ == columns_)
+                {
+                    column_--;
+                    wrap_ = true;
+                }
+            }
+        }
+
+        /// @brief Moves the caret down, scrolling at the bottom.
+        auto index() -> void
+        {
+            wrap_ = false;
+
+            if (row_ + 1 < rows_)
+                row_++;
+            else
+                scroll_up(1);
+        }
+
+        /// @brief Moves the caret up, scrolling at the top.
+        auto reverse_index() -> void
+        {
+            wrap_ = false;
+
+            if (row_ > 0)
+                row_--;
+            else
+                scroll_down(1);
+        }
+
+        /// @brief Scrolls the page up, adding blank lines at the bottom.
+        auto scroll_up(std::size_t n) -> void
+        {
+            n = std::min(n, rows_);
+            top_ = (top_ + n) % rows_;
+            blank(rows_ - n, 0, rows_ - 1, columns_);
+        }
+
+        /// @brief Scrolls the page down, adding blank lines at the top.
+        auto scroll_down(std::size_t n) -> void
+        {
+            n = std::min(n, rows_);
+            top_ = (top_ + rows_ - n) % rows_;
+            if (n != 0)
+                blank(0, 0, n - 1, columns_);
+        }
+
+        /// @brief Blanks cells in reading order.
+        /// @param[in] row_first    First row.
+        /// @param[in] column_first First column of the first row.
+        /// @param[in] row_last     Last row.
+        /// @param[in] column_end   End column of the last row, exclusive.
+        auto blank(const std::size_t row_first, const std::size_t column_first, const std::size_t row_last, const std::size_t column_end) -> void
+        {
+            cell empty;
+            empty.attr.bg = pen_.bg;
+
+            for (std::size_t r = row_first; r <= row_last && r < rows_; r++)
+            {
+                cell* const line = line_data(r);
+                const std::size_t from = r == row_first ? column_first : 0;
+                const std::size_t to = r == row_last ? std::min(column_end, columns_) : columns_;
+
+                if (from < to)
+                    std::fill(line + from, line + to, empty);
+            }
+        }
+
+        /// @brief Saves the caret position and the pen.
+        auto save() -> void
+        {
+            saved_row_ = row_;
+            saved_column_ = column_;
+            saved_pen_ = pen_;
+        }
+
+        /// @brief Restores the caret position and the pen.
+        auto restore() -> void
+        {
+            wrap_ = false;
+            row_ = saved_row_;
+            column_ = saved_column_;
+            pen_ = saved_pen_;
+        }
+
+        /// @brief Appends a code point as UTF-8.
+        static auto encode(std::string& s, const char32_t ch) -> void
+        {
+            if (ch < 0x80)
+                s += static_cast<char>(ch);
+            else if (ch < 0x800)
+            {
+                s += static_cast<char>(0xC0 | ch >> 6);
+                s += static_cast<char>(0x80 | (ch & 0x3F));
+            }
+            else if (ch < 0x10000)
+            {
+                s += static_cast<char>(0xE0 | ch >> 12);
+                s += static_cast<char>(0x80 | (ch >> 6 & 0x3F));
+                s += static_cast<char>(0x80 | (ch & 0x3F));
+            }
+            else
+            {
+                s += static_cast<char>(0xF0 | ch >> 18);
+                s += static_cast<char>(0x80 | (ch >> 12 & 0x3F));
+                s += static_cast<char>(0x80 | (ch >> 6 & 0x3F));
+                s += static_cast<char>(0x80 | (ch & 0x3F));
+            }
+        }
+
+        /// @brief Number of rows.
+        std::size_t rows_;
+
+        /// @brief Number of columns.
+        std::size_t columns_;
+
+        /// @brief Whether line feed also returns the caret.
+        bool newline_;
+
+        /// @brief Cells, one row after another in storage order.
+        std::vector<cell> cells_;
+
+        /// @brief Storage row of the top screen row, advanced when scrolling.
+        std::size_t top_ = 0;
+
+        /// @brief Byte stream parser.
+        vt_parser<vt> parser_;
+
+        /// @brief Caret row.
+        std::size_t row_ = 0;
+
+        /// @brief Caret column.
+        std::size_t column_ = 0;
+
+        /// @brief Whether the next character wraps to the next line first.
+        bool wrap_ = false;
+
+        /// @brief Style of the following characters.
+        style pen_;
+
+        /// @brief Saved caret row.
+        std::size_t saved_row_ = 0;
+
+        /// @brief Saved caret column.
+        std::size_t saved_column_ = 0;
+
+        /// @brief Saved pen.
+        style saved_pen_;
+
+        /// @brief Code point being decoded.
+        char32_t code_ = 0;
+
+        /// @brief Number of continuation bytes still expected.
+        unsigned need_ = 0;
+
+        /// @brief Bytes written so far.
+        std::uint64_t bytes_ = 0;
+
+        /// @brief Escape sequences seen so far.
+        std::uint64_t sequences_ = 0;
+    };
+
+
+    /// @brief Interprets a CSI object on a screen.
+    /// @tparam N Number of values.
+    /// @param[in,out] screen Screen.
+    /// @param[in]     obj    CSI object.
+    /// @return The screen reference.
+    /// @see ansi::csi
+    template <std::size_t N>
+    auto operator<<(vt& screen, const csi<N>& obj) -> vt&
+    {
+        char buf[3 + 4 * N];
+        const std::size_t len = ansi::render(obj, buf);
+        screen.write({buf, len});
+        return screen;
+    }
+
+    /// @brief Interprets text on a screen.
+    /// @param[in,out] screen Screen.
+    /// @param[in]     text   Text, may contain escape sequences.
+    /// @return The screen reference.
+    inline auto operator<<(vt& screen, const std::string_view text) -> vt&
+    {
+        screen.write(text);
+        return screen;
+    }
+}
@@ -4,15 +4,250 @@
 /// @version 1.0
 /// @date 2024-08-29
 /// @copyright Copyright (c) 2024
+module;
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
 export module ansi;
 
 export import <cansi>;
 
 import std;
 
+/// @brief ANSI Escape Codes.
+namespace ansi
+{
+    /// @brief Rendered sequences of a set of output manips.
+    /// @tparam Size Capacity in bytes.
+    template <std::size_t Size>
+    struct prefix_bytes
+    {
+        /// @brief Sequence bytes.
+        char data[Size];
+
+        /// @brief Number of sequence bytes.
+        std::size_t size;
+
+        /// @brief Sequence bytes.
+        /// @return View of the sequences.
+        constexpr auto view() const -> std::string_view { return {data, size}; }
+    };
+
+    /// @brief Sequences of a set of output manips, rendered at compile time.
+    /// @details Only this constant differs between style combinations; the code printing it is shared.
+    /// @tparam Manips ANSI CSI output manip, styles.
+    template <csi... Manips>
+    constexpr auto prefix = []
+    {
+        prefix_bytes<(max_length(Manips) + ... + 1)> p{};
+        ((p.size += ansi::render(Manips, p.data + p.size)), ...);
+        return p;
+    }();
+
+    /// @brief Stack buffer collecting one print, written to the stream in as few calls as possible.
+    /// @details Holds the whole output of typical prints, which then take a single write; longer ones are written in
+    /// chunks of the buffer size as it fills. Nothing is allocated on the heap. On Windows a standard stream attached to
+    /// a console is flushed and the text is converted on the stack and written with @c WriteConsoleW , as @c std::print
+    /// would, in chunks ending on whole UTF-8 characters.
+    class print_buffer
+    {
+    public:
+        /// @brief Capacity in bytes.
+        static constexpr std::size_t capacity = 1024;
+
+        /// @brief Output iterator appending to the buffer, as needed by @c std::vformat_to .
+        class iterator
+        {
+        public:
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+
+            /// @brief Points at a buffer.
+            /// @param[in] buffer Buffer appended to.
+            explicit iterator(print_buffer& buffer) : buffer_(&buffer) {}
+
+            auto operator*() -> iterator& { return *this; }
+            auto operator++() -> iterator& { return *this; }
+            auto operator++(int) -> iterator { return *this; }
+
+            /// @brief Appends a character.
+            auto operator=(const char c) -> iterator&
+            {
+                buffer_->put(c);
+                return *this;
+            }
+
+        private:
+            print_buffer* buffer_ = nullptr;
+        };
+
+        /// @brief Creates an empty buffer.
+        /// @param[out] stream Output stream written to.
+        explicit print_buffer(std::ostream& stream) : stream_(&stream), console_(console_of(stream)) {}
+
+        print_buffer(const print_buffer&) = delete;
+        auto operator=(const print_buffer&) -> print_buffer& = delete;
+
+        /// @brief Appends a character, writing the buffer first if it is full.
+        auto put(const char c) -> void
+        {
+            if (size_ == capacity)
+                spill();
+
+            data_[size_++] = c;
+        }
+
+        /// @brief Appends characters, writing the buffer each time it fills.
+        auto append(std::string_view s) -> void
+        {
+            while (s.size() > capacity - size_)
+            {
+                const std::size_t n = capacity - size_;
+                std::copy_n(s.data(), n, data_ + size_);
+                size_ = capacity;
+                spill();
+                s.remove_prefix(n);
+            }
+
+            std::copy_n(s.data(), s.size(), data_ + size_);
+            size_ += s.size();
+        }
+
+        /// @brief Writes the buffered characters.
+        auto write() -> void
+        {
+            write(size_);
+            size_ = 0;
+        }
+
+    private:
+        /// @brief Finds the console a stream writes to.
+        /// @details Only the standard streams still writing through the buffer they had at startup count, so that output
+        /// redirected to another buffer, such as a recorder, is left to it.
+        /// @param[in] stream Output stream.
+        /// @return Console handle, null if the stream is not attached to a console.
+        static auto console_of([[maybe_unused]] const std::ostream& stream) -> void*
+        {
+#ifdef _WIN32
+            const auto handle = [](const DWORD id) -> HANDLE
+            {
+                const HANDLE h = GetStdHandle(id);
+                DWORD mode;
+                return h != INVALID_HANDLE_VALUE && h != nullptr && GetConsoleMode(h, &mode) ? h : nullptr;
+            };
+
+            static const HANDLE out = handle(STD_OUTPUT_HANDLE);
+            static const HANDLE err = handle(STD_ERROR_HANDLE);
+
+            if (&stream == &std::cout && stream.rdbuf() == startup_buffers[0])
+                return out;
+            if (&stream == &std::cerr && stream.rdbuf() == startup_buffers[1])
+                return err;
+            if (&stream == &std::clog && stream.rdbuf() == startup_buffers[2])
+                return err;
+#endif
+            return nullptr;
+        }
+
+        /// @brief Writes leading buffered characters.
+        /// @param[in] count Number of characters.
+        auto write(const std::size_t count) -> void
+        {
+#ifdef _WIN32
+            if (console_)
+            {
+                // A UTF-8 sequence never takes more UTF-16 units than bytes.
+                wchar_t wide[capacity];
+                const int n = MultiByteToWideChar(CP_UTF8, 0, data_, static_cast<int>(count), wide, static_cast<int>(capacity));
+
+                stream_->flush();
+                DWORD written;
+                WriteConsoleW(console_, wide, static_cast<DWORD>(n), &written, nullptr);
+                return;
+            }
+#endif
+            stream_->write(data_, static_cast<std::streamsize>(count));
+        }
+
+        /// @brief Writes a full buffer, keeping back a trailing incomplete UTF-8 character for a console.
+        auto spill() -> void
+        {
+            std::size_t count = size_;
+
+            if (console_)
+            {
+                std::size_t lead = size_ - 1;
+                while (lead > 0 && size_ - lead < 4 && (data_[lead] & 0xC0) == 0x80)
+                    lead--;
+
+                const auto c = static_cast<unsigned char>(data_[lead]);
+                const std::size_t length = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+                if (lead + length > size_)
+                    count = lead;
+            }
+
+            write(count);
+            std::copy(data_ + count, data_ + size_, data_);
+            size_ -= count;
+        }
+
+        /// @brief Output stream.
+        std::ostream* stream_;
+
+        /// @brief Console written to directly, null for other streams.
+        void* console_;
+
+#ifdef _WIN32
+        /// @brief Buffers of @c std::cout, @c std::cerr and @c std::clog at startup.
+        static inline std::streambuf* const startup_buffers[] = {std::cout.rdbuf(), std::cerr.rdbuf(), std::clog.rdbuf()};
+#endif
+
+        /// @brief Buffered characters.
+        char data_[capacity];
+
+        /// @brief Number of buffered characters.
+        std::size_t size_ = 0;
+    };
+}
+
 /// @brief ANSI Escape Codes.
 export namespace ansi
 {
+    /// @brief Prints ANSI-styled unicode to an output stream with type-erased format arguments.
+    /// @details The single out-of-line function behind every @c print and @c println ; a reset follows the text when
+    /// the prefix is not empty. The styles, the formatted text and the reset are collected in a stack buffer and written
+    /// at once, so printing does not allocate; text longer than the buffer is written in several chunks. On Windows,
+    /// standard streams attached to a console are written as UTF-16 with @c WriteConsoleW so that it shows Unicode text;
+    /// other streams receive the UTF-8 bytes unchanged.
+    /// @param[out] stream  Output stream.
+    /// @param[in]  prefix  Rendered style sequences.
+    /// @param[in]  fmt     Format string.
+    /// @param[in]  args    Format arguments.
+    /// @param[in]  newline Whether to end the line and flush the output stream.
+    auto vprint_styled(std::ostream& stream, const std::string_view prefix, const std::string_view fmt, const std::format_args args,
+        const bool newline = false) -> void
+    {
+        print_buffer buffer(stream);
+        buffer.append(prefix);
+        std::vformat_to(print_buffer::iterator(buffer), fmt, args);
+
+        if (!prefix.empty())
+            buffer.append(table::sgr[0].view());
+        if (newline)
+            buffer.put('\n');
+
+        buffer.write();
+
+        if (newline)
+            stream.flush();
+    }
+
     /// @brief Prints ANSI-styled unicode to an output stream with variadic format string.
     /// @tparam Manips ANSI CSI output manip, styles.
     /// @tparam Args   Variadic arguments to put in the string.
@@ -22,14 +257,7 @@ export namespace ansi
     template <csi... Manips, typename... Args>
     auto print(std::ostream& stream, const std::string_view fmt, Args&&... args) -> void
     {
-        if constexpr (sizeof...(Manips) > 0)
-        {
-            ((stream << Manips), ...);
-
-            std::vprint_unicode(stream, fmt, std::make_format_args(args...));
-            stream << reset;
-        }
-        else std::vprint_unicode(stream, fmt, std::make_format_args(args...));
+        ansi::vprint_styled(stream, prefix<Manips...>.view(), fmt, std::make_format_args(args...));
     }
 
     /// @brief Prints ANSI-styled unicode to standard output stream with variadic format string.
@@ -40,7 +268,7 @@ export namespace ansi
     template <csi... Manips, typename... Args>
     auto print(const std::string_view fmt, Args&&... args) -> void
     {
-        ansi::print<Manips...>(std::cout, fmt, std::forward<Args>(args)...);
+        ansi::vprint_styled(std::cout, prefix<Manips...>.view(), fmt, std::make_format_args(args...));
     }
 
     /// @brief Prints ANSI-styled unicode to an output stream with variadic format string; flushes the output stream and ends the line.
@@ -52,8 +280,7 @@ export namespace ansi
     template <csi... Manips, typename... Args>
     auto println(std::ostream& stream, const std::string_view fmt, Args&&... args) -> void
     {
-        ansi::print<Manips...>(stream, fmt, std::forward<Args>(args)...);
-        stream << std::endl;
+        ansi::vprint_styled(stream, prefix<Manips...>.view(), fmt, std::make_format_args(args...), true);
     }
 
     /// @brief Prints ANSI-styled unicode to standard output stream with variadic format string; flushes the standard output stream and ends the line.
@@ -64,7 +291,7 @@ export namespace ansi
     template <csi... Manips, typename... Args>
     auto println(const std::string_view fmt, Args&&... args) -> void
     {
-        ansi::println<Manips...>(std::cout, fmt, std::forward<Args>(args)...);
+        ansi::vprint_styled(std::cout, prefix<Manips...>.view(), fmt, std::make_format_args(args...), true);
     }
 
     /// @brief Flushes the output stream and ends the line.
@@ -0,0 +1,55 @@
+# Compares the cost of ansi::print call sites against the former implementation, which instantiated the whole
+# formatting path per style combination. Builds tools/PrintBloat in both variants and reports compile time, object and
+# executable size, and the number of print and format instantiations left in the object file.
+#
+# Run from a Developer PowerShell for Visual Studio so that msbuild and dumpbin are on the path:
+#   .\scripts\measure-print-bloat.ps1 -Configuration Release -Platform x64
+
+param(
+    [string] $Configuration = "Release",
+    [string] $Platform = "x64"
+)
+
+$ErrorActionPreference = "Stop"
+
+$root = Split-Path -Parent $PSScriptRoot
+$project = Join-Path $root "tools\PrintBloat\PrintBloat.vcxproj"
+$common = @("/nologo", "/v:minimal", "/p:Configuration=$Configuration", "/p:Platform=$Platform", "/p:SolutionDir=$(Split-Path -Parent $root)\")
+
+function Measure-Variant([string] $name, [bool] $baseline)
+{
+    $flag = "/p:PrintBloatBaseline=$($baseline.ToString().ToLower())"
+
+    # Builds the library module first, so the timed rebuild covers only the call sites.
+    & msbuild $project @common $flag | Out-Null
+    if ($LASTEXITCODE -ne 0) { throw "$name build failed" }
+
+    $time = Measure-Command { & msbuild $project @common $flag "/t:Rebuild" "/p:BuildProjectReferences=false" | Out-Null }
+    if ($LASTEXITCODE -ne 0) { throw "$name rebuild failed" }
+
+    $intermediate = Join-Path $root "tools\PrintBloat\$Platform\$Configuration"
+    if ($baseline) { $intermediate = Join-Path $intermediate "Baseline" }
+
+    $object = Get-Item (Join-Path $intermediate "print-bloat.obj")
+    $suffix = if ($baseline) { "Baseline" } else { "" }
+    $executable = Get-Item (Join-Path (Split-Path -Parent $root) "$Platform\$Configuration\Tools\PrintBloat$suffix.exe")
+
+    # Every distinct function instantiation is a COMDAT section with its own symbol.
+    $symbols = & dumpbin /nologo /symbols $object.FullName
+    $count = { param($pattern) ($symbols | Select-String -Pattern $pattern | ForEach-Object { ($_ -split '\|')[-1].Trim() } | Sort-Object -Unique).Count }
+
+    [pscustomobject]@{
+        Variant            = $name
+        "Compile (s)"      = [math]::Round($time.TotalSeconds, 2)
+        "Object (KiB)"     = [math]::Round($object.Length / 1KB, 1)
+        "Executable (KiB)" = [math]::Round($executable.Length / 1KB, 1)
+        "print"            = & $count 'SECT.*println<'
+        "make_format_args" = & $count 'SECT.*make_format_args<'
+        "operator<<"       = & $count 'SECT.*operator<<<'
+    }
+}
+
+@(
+    Measure-Variant "baseline" $true
+    Measure-Variant "type-erased" $false
+) | Format-Table -AutoSize
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Input loop shared by the filter tools.
+namespace tools
+{
+    // Size of the chunks handed to the filter.
+    constexpr std::size_t chunk = 1 << 20;
+
+    // Switches standard input and output to binary mode on Windows, where text mode turns CR LF into LF on the way in,
+    // stops at Ctrl+Z, and turns LF into CR LF on the way out. Call before any I/O.
+    inline auto binary_stdio() -> void
+    {
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    }
+
+    // Reads standard input as it arrives, without waiting for a whole chunk.
+    inline auto read_stdin(char* const buf, const std::size_t size) -> long
+    {
+#ifdef _WIN32
+        return _read(0, buf, static_cast<unsigned>(size));
+#else
+        return static_cast<long>(::read(0, buf, size));
+#endif
+    }
+
+    // Feeds the files named by the arguments from first on, or standard input if there are none, to a filter in chunks.
+    // A short read from standard input means the writer is idle, e.g. under tail -f or an interactive program, so idle is
+    // called to bring the output up to date. Returns 1 after reporting a file that cannot be opened, otherwise 0.
+    template <typename Feed, typename Idle>
+    auto feed_input(const int argc, char* argv[], const int first, Feed&& feed, Idle&& idle) -> int
+    {
+        const auto buf = std::make_unique<char[]>(chunk);
+
+        if (first == argc)
+        {
+            for (;;)
+            {
+                const long n = read_stdin(buf.get(), chunk);
+                if (n <= 0)
+                    break;
+
+                feed({buf.get(), static_cast<std::size_t>(n)});
+
+                if (static_cast<std::size_t>(n) < chunk)
+                    idle();
+            }
+        }
+
+        for (int i = first; i < argc; i++)
+        {
+            std::ifstream file(argv[i], std::ios::binary);
+            if (!file)
+            {
+                std::perror(argv[i]);
+                return 1;
+            }
+
+            while (file.read(buf.get(), chunk) || file.gcount() > 0)
+                feed({buf.get(), static_cast<std::size_t>(file.gcount())});
+        }
+
+        return 0;
+    }
+}
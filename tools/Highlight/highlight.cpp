@@ -0,0 +1,21 @@
+#include <iostream>
+#include <string_view>
+#include <cansi>
+
+#include "../Common/input.hpp"
+
+// Colors plain logs from the files given as arguments, or from standard input, to standard output.
+int main(int argc, char* argv[])
+{
+    tools::binary_stdio();
+    std::ios::sync_with_stdio(false);
+
+    ansi::highlighter highlighter(std::cout);
+
+    const int status = tools::feed_input(argc, argv, 1,
+        [&](const std::string_view chunk) { highlighter.feed(chunk); },
+        [&] { highlighter.flush(); });
+
+    highlighter.finish();
+    return status;
+}
@@ -0,0 +1,51 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <cansi>
+
+#include "../Common/input.hpp"
+
+// Re-encodes the escape sequences in the files given as arguments, or in standard input, to fewer bytes on standard
+// output. Options: -s ROWSxCOLUMNS gives the screen size, enabling relative caret moves; -v reports the savings.
+int main(int argc, char* argv[])
+{
+    tools::binary_stdio();
+    std::ios::sync_with_stdio(false);
+
+    std::size_t rows = 0;
+    std::size_t columns = 0;
+    bool verbose = false;
+    int first = 1;
+
+    for (; first < argc && argv[first][0] == '-' && argv[first][1] != '\0'; first++)
+    {
+        if (std::strcmp(argv[first], "-v") == 0)
+            verbose = true;
+        else if (std::strcmp(argv[first], "-s") == 0 && first + 1 < argc)
+        {
+            char* end = nullptr;
+            rows = std::strtoul(argv[++first], &end, 10);
+            columns = *end == 'x' ? std::strtoul(end + 1, nullptr, 10) : 0;
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [-v] [-s ROWSxCOLUMNS] [FILE]..." << std::endl;
+            return 2;
+        }
+    }
+
+    ansi::optimize optimizer(std::cout, rows, columns);
+
+    const int status = tools::feed_input(argc, argv, first,
+        [&](const std::string_view chunk) { optimizer.feed(chunk); },
+        [&] { optimizer.flush(); });
+
+    optimizer.flush();
+
+    if (verbose && optimizer.bytes_in() > 0)
+        std::cerr << optimizer.bytes_in() << " -> " << optimizer.bytes_out() << " bytes ("
+                  << 100.0 * (1.0 - static_cast<double>(optimizer.bytes_out()) / static_cast<double>(optimizer.bytes_in())) << "% fewer)" << std::endl;
+
+    return status;
+}
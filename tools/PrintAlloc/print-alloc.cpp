@@ -0,0 +1,121 @@
+import std;
+import ansi;
+
+using namespace ansi::manipulators;
+
+// Checks that styled prints do not allocate once warmed up: the global operator new is replaced by one counting the
+// calls, and every print shape runs many times into a stream discarding its output. Reports the count of every shape
+// and exits with 1 if any of them allocated. Standard output, which may be a console with its own path on Windows, is
+// checked the same way. The former path through std::vprint_unicode is counted for comparison.
+
+namespace
+{
+    std::size_t allocations = 0;
+
+    auto allocate(const std::size_t size) -> void*
+    {
+        allocations++;
+
+        if (void* p = std::malloc(size != 0 ? size : 1))
+            return p;
+
+        throw std::bad_alloc();
+    }
+
+    // Stream buffer dropping everything written to it.
+    class sink final : public std::streambuf
+    {
+    public:
+        std::size_t bytes = 0;
+        std::size_t writes = 0;
+
+    protected:
+        auto overflow(const int_type c) -> int_type override
+        {
+            bytes++;
+            writes++;
+            return traits_type::not_eof(c);
+        }
+
+        auto xsputn(const char_type*, const std::streamsize n) -> std::streamsize override
+        {
+            bytes += static_cast<std::size_t>(n);
+            writes++;
+            return n;
+        }
+    };
+}
+
+auto operator new(const std::size_t size) -> void* { return allocate(size); }
+auto operator new[](const std::size_t size) -> void* { return allocate(size); }
+
+auto operator delete(void* p) noexcept -> void { std::free(p); }
+auto operator delete[](void* p) noexcept -> void { std::free(p); }
+auto operator delete(void* p, std::size_t) noexcept -> void { std::free(p); }
+auto operator delete[](void* p, std::size_t) noexcept -> void { std::free(p); }
+
+int main()
+{
+    constexpr int iterations = 10000;
+
+    sink buf;
+    std::ostream stream(&buf);
+
+    const std::string_view symbol = "EURUSD";
+    const std::string long_text(4000, 'x');
+
+    const std::pair<const char*, std::function<void(int)>> shapes[] = {
+        {"print", [&](const int i) { ansi::print(stream, "order {} filled\n", i); }},
+        {"print styled", [&](const int i) { ansi::print<fg::green, text::bold>(stream, "{} {:>8} @ {:.5f}\n", symbol, i, 1.08 + i * 1e-5); }},
+        {"println styled", [&](const int i) { ansi::println<fg::rgb(255, 128, 0), bg::set(236)>(stream, "{:#x} {}", i, i % 2 == 0); }},
+        {"println long", [&](const int i) { ansi::println<text::italic>(stream, "{} {}", i, long_text); }},
+    };
+
+    bool failed = false;
+
+    for (const auto& [name, shape] : shapes)
+    {
+        // The first calls may set up locales and stream state.
+        shape(0);
+
+        const std::size_t writes = buf.writes;
+        allocations = 0;
+
+        for (int i = 0; i < iterations; i++)
+            shape(i);
+
+        const std::size_t count = allocations;
+        std::cout << std::format("{:<16}{:>10} allocations{:>10.2f} writes per call\n", name, count, static_cast<double>(buf.writes - writes) / iterations);
+
+        failed |= count != 0;
+    }
+
+    // Standard output, overwriting one line in place.
+    ansi::print<fg::green>(std::cout, "{:>16}\r", 0);
+    allocations = 0;
+
+    for (int i = 0; i < iterations; i++)
+        ansi::print<fg::green>(std::cout, "{:>16}\r", i);
+
+    const std::size_t console = allocations;
+    std::cout << std::format("{:<16}{:>10} allocations\n", "print cout", console);
+    failed |= console != 0;
+
+    // The former path, for comparison only.
+    std::vprint_unicode(stream, "{} {}\n", std::make_format_args(symbol, long_text));
+    allocations = 0;
+
+    for (int i = 0; i < iterations; i++)
+        std::vprint_unicode(stream, "{} {}\n", std::make_format_args(symbol, long_text));
+
+    std::cout << std::format("{:<16}{:>10} allocations\n", "vprint_unicode", allocations);
+
+    if (failed)
+    {
+        std::cout << "FAILED: steady-state prints allocated" << std::endl;
+        return 1;
+    }
+
+    std::cout << "OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,55 @@
+import std;
+import ansi;
+
+using namespace ansi::manipulators;
+
+// Instantiates many distinct styled call sites, the shape of a large code base, so that the measure-print-bloat script
+// can compare instantiation counts, object size and compile time. PRINT_BLOAT_BASELINE selects a copy of the former
+// print, which wrote every manip and formatted inside each instantiation.
+
+#ifdef PRINT_BLOAT_BASELINE
+
+namespace baseline
+{
+    template <ansi::csi... Manips, typename... Args>
+    auto println(std::ostream& stream, const std::string_view fmt, Args&&... args) -> void
+    {
+        if constexpr (sizeof...(Manips) > 0)
+        {
+            ((stream << Manips), ...);
+
+            std::vprint_unicode(stream, fmt, std::make_format_args(args...));
+            stream << reset;
+        }
+        else std::vprint_unicode(stream, fmt, std::make_format_args(args...));
+
+        stream << std::endl;
+    }
+}
+
+#define PRINTLN baseline::println
+
+#else
+
+#define PRINTLN ansi::println
+
+#endif
+
+// One call site per color, each with its own style combination.
+template <std::size_t... I>
+auto sites(std::ostream& stream, std::index_sequence<I...>) -> void
+{
+    constexpr auto c = [](const std::size_t i) { return static_cast<ansi::byte>(i); };
+
+    ((PRINTLN<fg::set(c(I))>(stream, "{}", I)), ...);
+    ((PRINTLN<fg::set(c(I)), bg::set(c(255 - I))>(stream, "{} {}", I, "text")), ...);
+    ((PRINTLN<fg::rgb(c(I), 0, c(255 - I)), text::bold>(stream, "{} {:.2f} {}", I, I / 255.0, 'c')), ...);
+}
+
+auto main() -> int
+{
+    std::ostringstream sink;
+    sites(sink, std::make_index_sequence<256>());
+
+    std::cout << sink.str().size() << " bytes printed by " << 3 * 256 << " call sites" << std::endl;
+}
@@ -0,0 +1,319 @@
+// Measures what a styled line costs as seen by a terminal: every output path of the library writes into the slave side
+// of a pseudo-terminal, and the time from the call to the bytes being readable on the master side is recorded, then
+// the throughput of flushing every line under sustained load. Results go to standard output as JSON. Linux only:
+//   g++ -std=c++23 -O2 -I include tools/PtyLatency/pty-latency.cpp -o pty-latency -lutil
+// Building with PTY_LATENCY_MODULE, and the ansi module available to the compiler, adds the ansi::println path; GCC
+// cannot build the module, so Linux builds list that path under "skipped" in the output instead.
+//
+// Options: --iterations N  latency samples per path, 10000 by default,
+//          --seconds S     duration of the throughput run per path, 1 by default.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define _ANSI_EMIT
+#include "ansi.h"
+#include <cansi>
+
+#ifdef PTY_LATENCY_MODULE
+import ansi;
+#endif
+
+using namespace ansi::manipulators;
+using clock_type = std::chrono::steady_clock;
+
+// Stream buffer writing to a file descriptor on flush, counting the write calls.
+class fd_buf final : public std::streambuf
+{
+public:
+    explicit fd_buf(const int fd) : fd_(fd) { setp(buf_, buf_ + sizeof buf_); }
+
+    std::size_t writes = 0;
+    std::size_t bytes = 0;
+
+protected:
+    auto overflow(const int_type c) -> int_type override
+    {
+        if (sync() != 0)
+            return traits_type::eof();
+
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+
+        return traits_type::not_eof(c);
+    }
+
+    auto sync() -> int override
+    {
+        const char* p = pbase();
+        while (p != pptr())
+        {
+            const auto n = ::write(fd_, p, static_cast<std::size_t>(pptr() - p));
+            if (n < 0)
+                return -1;
+
+            writes++;
+            bytes += static_cast<std::size_t>(n);
+            p += n;
+        }
+
+        setp(buf_, buf_ + sizeof buf_);
+        return 0;
+    }
+
+private:
+    int fd_;
+    char buf_[4096];
+};
+
+// Counts of the write calls made by a FILE opened with counting_file().
+struct fd_counts
+{
+    int fd;
+    std::size_t writes = 0;
+    std::size_t bytes = 0;
+};
+
+// Opens an unbuffered FILE on a file descriptor that counts the write calls it makes.
+static auto counting_file(fd_counts& counts) -> std::FILE*
+{
+    cookie_io_functions_t io{};
+    io.write = [](void* cookie, const char* p, const std::size_t size) -> ssize_t
+    {
+        auto& c = *static_cast<fd_counts*>(cookie);
+        const auto n = ::write(c.fd, p, size);
+        if (n > 0)
+        {
+            c.writes++;
+            c.bytes += static_cast<std::size_t>(n);
+        }
+        return n;
+    };
+
+    std::FILE* file = fopencookie(&counts, "w", io);
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    return file;
+}
+
+// Writer side of one output path: emits line i, flushed, and reports the bytes and write calls so far.
+struct path
+{
+    const char* name;
+    std::function<void(unsigned)> line;
+    std::function<std::size_t()> bytes;
+    std::function<std::size_t()> writes;
+};
+
+// Reads everything available from the master side, blocking up to the timeout for the first byte.
+static auto drain(const int fd, char* buf, const std::size_t size, const int timeout) -> std::size_t
+{
+    pollfd p{fd, POLLIN, 0};
+    if (poll(&p, 1, timeout) <= 0)
+        return 0;
+
+    const auto n = ::read(fd, buf, size);
+    return n > 0 ? static_cast<std::size_t>(n) : 0;
+}
+
+static auto nanoseconds(const clock_type::duration d) -> long long
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+}
+
+// Time from the call to the line feed arriving on the master side, one line at a time.
+static auto latency(const path& p, const int master, const unsigned iterations, std::string& json) -> void
+{
+    std::vector<long long> samples;
+    samples.reserve(iterations);
+
+    char buf[1 << 16];
+    const std::size_t bytes = p.bytes();
+
+    for (unsigned i = 0; i < iterations; i++)
+    {
+        const auto start = clock_type::now();
+        p.line(i);
+
+        for (bool done = false; !done;)
+        {
+            const std::size_t n = drain(master, buf, sizeof buf, 1000);
+            if (n == 0)
+            {
+                std::cerr << p.name << ": line " << i << " did not arrive" << std::endl;
+                std::exit(1);
+            }
+
+            done = std::memchr(buf, '\n', n) != nullptr;
+        }
+
+        samples.push_back(nanoseconds(clock_type::now() - start));
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    long long sum = 0;
+    for (const long long s : samples)
+        sum += s;
+
+    const auto at = [&](const double q) { return samples[static_cast<std::size_t>(q * (samples.size() - 1))]; };
+
+    json += "\"latency_ns\": {\"min\": " + std::to_string(samples.front());
+    json += ", \"p50\": " + std::to_string(at(0.5));
+    json += ", \"p90\": " + std::to_string(at(0.9));
+    json += ", \"p99\": " + std::to_string(at(0.99));
+    json += ", \"max\": " + std::to_string(samples.back());
+    json += ", \"mean\": " + std::to_string(sum / static_cast<long long>(samples.size()));
+    json += "}, \"bytes_per_line\": " + std::to_string((p.bytes() - bytes) / iterations);
+}
+
+// Ratio that stays valid JSON when nothing was measured.
+static auto per(const double n, const double d) -> double { return d > 0 ? n / d : 0; }
+
+// Lines flushed one by one from a writer thread for a fixed time, while the master side is drained.
+static auto throughput(const path& p, const int master, const double seconds, std::string& json) -> void
+{
+    std::atomic<bool> done = false;
+    std::atomic<std::size_t> written = 0;
+    unsigned lines = 0;
+
+    const std::size_t bytes = p.bytes();
+    const std::size_t writes = p.writes();
+    const auto start = clock_type::now();
+    const auto until = start + std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(seconds));
+
+    std::jthread writer([&]
+    {
+        while (clock_type::now() < until)
+            p.line(lines++);
+
+        written = p.bytes() - bytes;
+        done = true;
+    });
+
+    std::vector<char> buf(1 << 20);
+    std::size_t read = 0;
+
+    while (!done || read < written)
+        read += drain(master, buf.data(), buf.size(), 100);
+
+    const double elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+    writer.join();
+
+    json += "\"throughput\": {\"seconds\": " + std::to_string(elapsed);
+    json += ", \"lines\": " + std::to_string(lines);
+    json += ", \"bytes\": " + std::to_string(read);
+    json += ", \"lines_per_second\": " + std::to_string(per(lines, elapsed));
+    json += ", \"mib_per_second\": " + std::to_string(per(static_cast<double>(read), elapsed) / (1 << 20));
+    json += ", \"writes_per_line\": " + std::to_string(per(static_cast<double>(p.writes() - writes), lines));
+    json += "}";
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned iterations = 10000;
+    double seconds = 1;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string_view option = argv[i];
+        if (option == "--iterations")
+            iterations = static_cast<unsigned>(std::max(1L, std::strtol(argv[i + 1], nullptr, 10)));
+        else if (option == "--seconds")
+            seconds = std::strtod(argv[i + 1], nullptr);
+    }
+
+    int master = -1;
+    int slave = -1;
+    if (openpty(&master, &slave, nullptr, nullptr, nullptr) != 0)
+    {
+        std::perror("openpty");
+        return 1;
+    }
+
+    // Raw mode keeps the bytes as written, without line feeds turned into CR LF.
+    termios mode{};
+    tcgetattr(slave, &mode);
+    cfmakeraw(&mode);
+    tcsetattr(slave, TCSANOW, &mode);
+
+    // The C accumulator writes through an unbuffered FILE, counting the write calls it makes.
+    fd_counts c_counts{slave};
+    std::FILE* file = counting_file(c_counts);
+
+    ansi_buf c;
+    ansi_buf_init(&c, file);
+
+    fd_buf buf(slave);
+    std::ostream stream(&buf);
+
+    const std::vector<path> paths = {
+        {
+            "ansi.h",
+            [&](const unsigned i)
+            {
+                ANSI_BUF_PUT(&c, ansi_fg_set, static_cast<unsigned char>(i));
+                ansi_buf_puts(&c, BOLD "styled line" RESET "\n");
+                ansi_buf_flush(&c);
+            },
+            [&] { return c_counts.bytes; },
+            [&] { return c_counts.writes; },
+        },
+        {
+            "csi",
+            [&](const unsigned i) { stream << fg::set(static_cast<ansi::byte>(i)) << text::bold << "styled line" << reset << '\n' << std::flush; },
+            [&] { return buf.bytes; },
+            [&] { return buf.writes; },
+        },
+#ifdef PTY_LATENCY_MODULE
+        {
+            "println",
+            [&](unsigned) { ansi::println<fg::red, text::bold>(stream, "styled line"); },
+            [&] { return buf.bytes; },
+            [&] { return buf.writes; },
+        },
+#endif
+    };
+
+    std::string json = "{\"iterations\": " + std::to_string(iterations) + ", \"paths\": [";
+
+    for (std::size_t i = 0; i < paths.size(); i++)
+    {
+        json += i > 0 ? ", {" : "{";
+        json += "\"name\": \"" + std::string(paths[i].name) + "\", ";
+        latency(paths[i], master, iterations, json);
+        json += ", ";
+        throughput(paths[i], master, seconds, json);
+        json += "}";
+    }
+
+    json += "]";
+#ifndef PTY_LATENCY_MODULE
+    json += ", \"skipped\": [{\"name\": \"println\", \"reason\": \"built without PTY_LATENCY_MODULE\"}]";
+#endif
+    json += "}";
+    std::cout << json << std::endl;
+
+    std::fclose(file);
+    close(slave);
+    close(master);
+    return 0;
+}